@@ -0,0 +1,49 @@
+// Copyright (c) 2020 Lauro Oyen, FmEngine contributors. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md for full terms. This notice is not to be removed.
+
+#pragma once
+
+#include "../../Engine/Source/Utility/CoreTypes.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+namespace FM
+{
+	namespace Benchmark
+	{
+		/// Calls func() the given number of times and returns the duration of the fastest call in microseconds.
+		/// The fastest call is the least disturbed by other processes, it is the most stable number between runs.
+		template <typename Func>
+		double Measure(usize runs, Func func)
+		{
+			double best = 1e30;
+
+			for (usize i = 0; i < runs; i++)
+			{
+				const auto start = std::chrono::steady_clock::now();
+				func();
+				const auto end = std::chrono::steady_clock::now();
+
+				best = std::min(best, std::chrono::duration<double, std::micro>(end - start).count());
+			}
+
+			return best;
+		}
+
+		/// Keeps the compiler from removing the computation of a value that is otherwise unused.
+		template <typename T>
+		void Consume(const T& value)
+		{
+			[[maybe_unused]] static volatile T sink;
+			sink = value;
+		}
+
+		/// Prints a line of the result table.
+		inline void Report(const char* name, usize count, double microseconds)
+		{
+			std::printf("  %-48s %9llu %12.1f us %8.2f ns/item\n", name, static_cast<unsigned long long>(count), microseconds, microseconds * 1000.0 / count);
+		}
+	}
+}
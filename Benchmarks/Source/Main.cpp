@@ -0,0 +1,18 @@
+// Copyright (c) 2020 Lauro Oyen, FmEngine contributors. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md for full terms. This notice is not to be removed.
+
+// Standalone microbenchmarks of engine code, build in Release for meaningful numbers.
+
+namespace FM
+{
+	void RunViewBenchmark();
+	void RunMathBenchmark();
+}
+
+int main()
+{
+	FM::RunViewBenchmark();
+	FM::RunMathBenchmark();
+
+	return 0;
+}
@@ -0,0 +1,97 @@
+// Copyright (c) 2020 Lauro Oyen, FmEngine contributors. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md for full terms. This notice is not to be removed.
+
+#include "Benchmark.h"
+
+#include "../../Engine/Source/Utility/Math/Matrix.h"
+#include "../../Engine/Source/Utility/Math/Vector.h"
+#include "../../Engine/Source/Utility/Math/Matrix4A.h"
+#include "../../Engine/Source/Utility/Math/Vector4A.h"
+
+#include <random>
+#include <vector>
+
+namespace FM
+{
+	/// Compares Vector4A and Matrix4A with the scalar Vector4 and Matrix4 on arrays of random inputs.
+	/// Inputs are converted up front, so only the operations themselves are measured.
+	void RunMathBenchmark()
+	{
+		const usize count = 4096;
+		const usize runs = 50;
+
+		std::mt19937 engine(1);
+		std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+
+		std::vector<Matrix4> lhs(count), rhs(count), matrices(count);
+		std::vector<Vector4> a(count), b(count);
+		std::vector<Vector3> a3(count), b3(count), crosses(count);
+		std::vector<float> dots(count);
+
+		for (usize i = 0; i < count; i++)
+		{
+			for (usize r = 0; r < 4; r++)
+			{
+				for (usize c = 0; c < 4; c++)
+				{
+					lhs[i].m[r][c] = distribution(engine);
+					rhs[i].m[r][c] = distribution(engine);
+				}
+
+				a[i][r] = distribution(engine);
+				b[i][r] = distribution(engine);
+			}
+
+			a3[i] = Vector3(a[i].x, a[i].y, a[i].z);
+			b3[i] = Vector3(b[i].x, b[i].y, b[i].z);
+		}
+
+		std::vector<Matrix4A> lhsA(lhs.begin(), lhs.end()), rhsA(rhs.begin(), rhs.end()), matricesA(count);
+		std::vector<Vector4A> aA(a.begin(), a.end()), bA(b.begin(), b.end()), vectorsA(count);
+
+		std::printf("Vector4A and Matrix4A versus scalar\n");
+
+		Benchmark::Report("Matrix4 * Matrix4", count, Benchmark::Measure(runs, [&]() {
+			for (usize i = 0; i < count; i++) matrices[i] = lhs[i] * rhs[i];
+		}));
+
+		Benchmark::Report("Matrix4A * Matrix4A", count, Benchmark::Measure(runs, [&]() {
+			for (usize i = 0; i < count; i++) matricesA[i] = lhsA[i] * rhsA[i];
+		}));
+
+		Benchmark::Report("Transpose(Matrix4)", count, Benchmark::Measure(runs, [&]() {
+			for (usize i = 0; i < count; i++) matrices[i] = Math::Transpose(lhs[i]);
+		}));
+
+		Benchmark::Report("Transpose(Matrix4A)", count, Benchmark::Measure(runs, [&]() {
+			for (usize i = 0; i < count; i++) matricesA[i] = Math::Transpose(lhsA[i]);
+		}));
+
+		Benchmark::Report("Inverted(Matrix4)", count, Benchmark::Measure(runs, [&]() {
+			for (usize i = 0; i < count; i++) matrices[i] = Math::Inverted(lhs[i]);
+		}));
+
+		Benchmark::Report("Inverted(Matrix4A)", count, Benchmark::Measure(runs, [&]() {
+			for (usize i = 0; i < count; i++) matricesA[i] = Math::Inverted(lhsA[i]);
+		}));
+
+		Benchmark::Report("Dot(Vector4)", count, Benchmark::Measure(runs, [&]() {
+			for (usize i = 0; i < count; i++) dots[i] = Math::Dot(a[i], b[i]);
+		}));
+
+		Benchmark::Report("Dot(Vector4A)", count, Benchmark::Measure(runs, [&]() {
+			for (usize i = 0; i < count; i++) dots[i] = Math::Dot(aA[i], bA[i]);
+		}));
+
+		Benchmark::Report("Cross(Vector3)", count, Benchmark::Measure(runs, [&]() {
+			for (usize i = 0; i < count; i++) crosses[i] = Math::Cross(a3[i], b3[i]);
+		}));
+
+		Benchmark::Report("Cross(Vector4A)", count, Benchmark::Measure(runs, [&]() {
+			for (usize i = 0; i < count; i++) vectorsA[i] = Math::Cross(aA[i], bA[i]);
+		}));
+
+		Benchmark::Consume(matrices[count - 1].m[0][0] + static_cast<Matrix4>(matricesA[count - 1]).m[0][0] + dots[count - 1]);
+		Benchmark::Consume(crosses[count - 1].x + static_cast<Vector4>(vectorsA[count - 1])[0]);
+	}
+}
@@ -0,0 +1,141 @@
+// Copyright (c) 2020 Lauro Oyen, FmEngine contributors. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md for full terms. This notice is not to be removed.
+
+#include "Benchmark.h"
+
+#include "../../Engine/Source/World/World.h"
+#include "../../Engine/Source/World/ArchetypeWorld.h"
+
+#include <vector>
+
+namespace FM
+{
+	namespace
+	{
+		struct Position { float x, y, z; };
+		struct Velocity { float x, y, z; };
+		struct Mass { float value; };
+
+		/// Every entity has a position, every second one a velocity and every third one a mass.
+		/// The views are driven by the smaller pools and test the others through their sparse index.
+		void Populate(World& world, usize count)
+		{
+			std::vector<Entity> entities(count);
+			world.Create(entities.data(), count);
+
+			std::vector<Entity> moving, heavy;
+
+			for (usize i = 0; i < count; i++)
+			{
+				if (i % 2 == 0) moving.push_back(entities[i]);
+				if (i % 3 == 0) heavy.push_back(entities[i]);
+			}
+
+			world.Assign<Position>(entities.data(), entities.size(), { 1.0f, 2.0f, 3.0f });
+			world.Assign<Velocity>(moving.data(), moving.size(), { 0.5f, 0.5f, 0.5f });
+			world.Assign<Mass>(heavy.data(), heavy.size(), { 2.0f });
+		}
+
+		/// Same distribution as above, which splits the entities over six archetypes.
+		void Populate(ArchetypeWorld& world, usize count)
+		{
+			for (usize i = 0; i < count; i++)
+			{
+				const Entity entity = world.Create();
+
+				world.Assign<Position>(entity) = { 1.0f, 2.0f, 3.0f };
+				if (i % 2 == 0) world.Assign<Velocity>(entity) = { 0.5f, 0.5f, 0.5f };
+				if (i % 3 == 0) world.Assign<Mass>(entity) = { 2.0f };
+			}
+		}
+	}
+
+	/// Iterates two and three component views at growing entity counts, followed by the same queries on ArchetypeWorld.
+	/// The time per entity must stay flat as the world grows, views are linear in the size of their smallest pool.
+	void RunViewBenchmark()
+	{
+		std::printf("View iteration\n");
+
+		for (usize count : { usize(10000), usize(100000), usize(1000000) })
+		{
+			World world;
+			Populate(world, count);
+
+			const usize runs = 10;
+
+			Benchmark::Report("View<Position, Velocity>::Each", count, Benchmark::Measure(runs, [&world]() {
+				float sum = 0.0f;
+				world.GetView<const Position, const Velocity>().Each([&sum](Entity, const Position& p, const Velocity& v) { sum += p.x * v.x; });
+				Benchmark::Consume(sum);
+			}));
+
+			Benchmark::Report("View<Position, Velocity, Mass>::Each", count, Benchmark::Measure(runs, [&world]() {
+				float sum = 0.0f;
+				world.GetView<const Position, const Velocity, const Mass>().Each([&sum](Entity, const Position& p, const Velocity& v, const Mass& m) { sum += p.x * v.x * m.value; });
+				Benchmark::Consume(sum);
+			}));
+
+			Benchmark::Report("View<Position, Velocity> iterator", count, Benchmark::Measure(runs, [&world]() {
+				auto view = world.GetView<const Position, const Velocity>();
+				float sum = 0.0f;
+
+				for (Entity entity : view)
+				{
+					sum += view.Get<const Position>(entity).x;
+				}
+
+				Benchmark::Consume(sum);
+			}));
+
+			Benchmark::Report("View<Position, Velocity, Mass> iterator", count, Benchmark::Measure(runs, [&world]() {
+				auto view = world.GetView<const Position, const Velocity, const Mass>();
+				float sum = 0.0f;
+
+				for (Entity entity : view)
+				{
+					sum += view.Get<const Mass>(entity).value;
+				}
+
+				Benchmark::Consume(sum);
+			}));
+		}
+
+		std::printf("Archetype iteration\n");
+
+		for (usize count : { usize(10000), usize(100000), usize(1000000) })
+		{
+			ArchetypeWorld world;
+			Populate(world, count);
+
+			const usize runs = 10;
+
+			Benchmark::Report("Archetype<Position, Velocity>::Each", count, Benchmark::Measure(runs, [&world]() {
+				float sum = 0.0f;
+				world.Each<Position, Velocity>([&sum](Entity, const Position& p, const Velocity& v) { sum += p.x * v.x; });
+				Benchmark::Consume(sum);
+			}));
+
+			Benchmark::Report("Archetype<Position, Velocity, Mass>::Each", count, Benchmark::Measure(runs, [&world]() {
+				float sum = 0.0f;
+				world.Each<Position, Velocity, Mass>([&sum](Entity, const Position& p, const Velocity& v, const Mass& m) { sum += p.x * v.x * m.value; });
+				Benchmark::Consume(sum);
+			}));
+
+			Benchmark::Report("Archetype<Position, Velocity>::EachChunk", count, Benchmark::Measure(runs, [&world]() {
+				float sum = 0.0f;
+				world.EachChunk<Position, Velocity>([&sum](const Entity*, usize n, Position* p, Velocity* v) {
+					for (usize i = 0; i < n; i++) sum += p[i].x * v[i].x;
+				});
+				Benchmark::Consume(sum);
+			}));
+
+			Benchmark::Report("Archetype<Position, Velocity, Mass>::EachChunk", count, Benchmark::Measure(runs, [&world]() {
+				float sum = 0.0f;
+				world.EachChunk<Position, Velocity, Mass>([&sum](const Entity*, usize n, Position* p, Velocity* v, Mass* m) {
+					for (usize i = 0; i < n; i++) sum += p[i].x * v[i].x * m[i].value;
+				});
+				Benchmark::Consume(sum);
+			}));
+		}
+	}
+}
@@ -16,18 +16,20 @@ struct PS_INPUT
     float2 texCoord : TEXCOORD;
 };
 
+// Matrices are stored row by row, like BufferVertex in Main.cpp.
+// Row major packing keeps the float3x4 at 3 registers, so the buffer is 176 bytes.
 struct BufferVertex
 {
-    float4x4 model;
-    float4x4 view;
-    float4x4 projection;
+    row_major float3x4 model;
+    row_major float4x4 view;
+    row_major float4x4 projection;
 };
 
 ConstantBuffer<BufferVertex> data : register(b0);
 
 void main(in VS_INPUT input, out PS_INPUT output)
 {
-    output.position = mul(data.model, float4(input.position, 1.0)).xyz;
+    output.position = mul(data.model, float4(input.position, 1.0));
     output.normal = mul((float3x3)data.model, input.normal);
 	output.texCoord = float2(input.texCoord.x, -input.texCoord.y); // Inverse Y for OpenGL
 
@@ -28,7 +28,7 @@ namespace FM::Game
 			Entity e = world.Create();
 
 			world.Assign<Transform>(e);
-			world.Assign<StaticMesh>(e).mesh = &meshA;
+			world.Assign<StaticMesh>(e, &meshA);
 		}
 
 		{
@@ -36,7 +36,7 @@ namespace FM::Game
 
 			Transform& tr = world.Assign<Transform>(e);
 			Rigidbody& rb = world.Assign<Rigidbody>(e);
-			world.Assign<StaticMesh>(e).mesh = &meshB;
+			world.Assign<StaticMesh>(e, &meshB);
 
 			tr.translation.y = 1.0f;
 			tr.scale = 0.5f;
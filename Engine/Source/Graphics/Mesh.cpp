@@ -29,6 +29,25 @@ namespace FM
 		file.read(reinterpret_cast<char*>(&mVertices[0]), sizeof(Vertex) * vertexCount);
 		file.read(reinterpret_cast<char*>(&mIndices[0]), sizeof(uint32) * indexCount);
 
+		// Bounds
+
+		mBoundingBox = BoundingBox(mVertices[0].position, mVertices[0].position);
+
+		for (const Vertex& vertex : mVertices)
+		{
+			Math::Enclose(mBoundingBox, vertex.position);
+		}
+
+		const Vector3 center = mBoundingBox.Center();
+		float radiusSquared = 0.0f;
+
+		for (const Vertex& vertex : mVertices)
+		{
+			radiusSquared = Math::Max(radiusSquared, Math::DistanceSquared(vertex.position, center));
+		}
+
+		mBoundingSphere = BoundingSphere(center, Math::Sqrt(radiusSquared));
+
 		// TODO: Move GL code somewhere else.
 
 		glGenBuffers(1, &vertexBuffer);
@@ -38,5 +38,8 @@ namespace FM
 		std::vector<SubMesh> mSubMeshes;
 		std::vector<Vertex> mVertices;
 		std::vector<uint32> mIndices;
+
+		BoundingBox mBoundingBox;			///< Bounds of the vertices in model space.
+		BoundingSphere mBoundingSphere;		///< Sphere around the center of the bounding box, containing all vertices.
 	};
 }
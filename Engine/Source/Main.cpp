@@ -25,10 +25,12 @@
 #include "Modules/DirectSound/AudioDevice.h"
 
 #include "World/World.h"
+#include "World/Scheduler.h"
 
 #include "Components/Components.h"
 
 #include "Utility/Time.h"
+#include "Utility/Threading/JobSystem.h"
 
 #include "Utility/Math/Math.h"
 
@@ -43,10 +45,12 @@ namespace FM::Game
 }
 
 World world;
+Scheduler scheduler;
 Win32Window window;
 AudioDevice* audioDevice;
 
 void Setup();
+void SetupSystems();
 void Update();
 
 struct IO
@@ -102,11 +106,13 @@ Matrix3 AxisConversion(EAxis srcF, EAxis srcU, EAxis dstF = EAxis::Z, EAxis dstU
 
 struct BufferVertex
 {
-	Matrix4 model;
+	Matrix3x4 model;
 	Matrix4 view;
 	Matrix4 projection;
 };
 
+static_assert(sizeof(BufferVertex) == 176, "BufferVertex must match the row major layout of the vertex shader.");
+
 BufferVertex bufferVertex;
 
 struct BufferPixel
@@ -152,7 +158,10 @@ int main()
 
 	audioDevice = new AudioDevice(window.GetWindowHandle());
 
+	GJobSystem.Init();
+
 	Setup();
+	SetupSystems();
 	Game::Setup(world);
 
 	GTime.Update(); // TODO: Ugly hack to reset dt.
@@ -160,6 +169,7 @@ int main()
 	while (window.Update())
 	{
 		GTime.Update();
+		world.NextTick();
 
 		io.mouseDelta = io.mousePos - io.prevMousePos;
 		io.prevMousePos = io.mousePos;
@@ -173,6 +183,8 @@ int main()
 		SwapBuffers(hDc);
 	}
 
+	GJobSystem.Shutdown();
+
 	wglMakeCurrent(NULL, NULL);
 	ReleaseDC((HWND)window.GetWindowHandle(), hDc);
 	wglDeleteContext(hRc);
@@ -186,6 +198,15 @@ UniformBuffer uboVertex, uboPixel;
 unsigned int VAO;
 HTexture baseColorMap;
 
+std::vector<Matrix3x4> modelMatrices;		///< Cached model matrix of every entity slot.
+std::vector<BoundingSphere> modelBounds;	///< Cached world space bounding sphere of every entity slot.
+uint32 renderTick = 0;						///< Tick of the world when the model matrices were last updated.
+
+std::vector<BoundingSphere> cullSpheres;	///< Bounding spheres of the entities to cull, in draw order.
+std::vector<Entity> cullEntities;			///< Entities of the spheres to cull.
+std::vector<const Mesh*> cullMeshes;		///< Meshes of the spheres to cull.
+std::vector<uint32> visible;				///< Indices of the visible spheres.
+
 unsigned int SetupVertexAttributes(std::vector<InputElementDesc> inputs)
 {
 	GLuint vertexArray;
@@ -256,6 +277,96 @@ void Setup()
 	baseColorMap = device.CreateTexture(desc);
 }
 
+void SetupSystems()
+{
+	// ================================================================
+	// AUDIO SYSTEM
+	// ================================================================
+
+	scheduler.Add<Writes<AudioSource>>("Audio", [](World& world)
+	{
+		int byteToLock;
+		int bytesToWrite;
+
+		audioDevice->GetPosition(byteToLock, bytesToWrite);
+
+		if (bytesToWrite)
+		{
+			// Samples, counts one for L and R together.
+			int samplesToWrite = bytesToWrite / 4; // Divided by BytesPerSample.
+
+			std::vector<int16> mixBuffer(samplesToWrite * 2, 0);
+
+			world.GetView<AudioSource>().Each([&](Entity e, AudioSource& source)
+			{
+				if (!source.isPlaying) return;
+
+				int offset = source.sampleIndex * 2;
+
+				for (int i = 0; i < samplesToWrite * 2; i += 2)
+				{
+					if (source.sampleIndex >= source.clip->mSampleCount)
+					{
+						if (source.repeat)
+						{
+							source.sampleIndex = 0;
+							offset = 0;
+						}
+						else
+						{
+							source.isPlaying = false;
+							source.sampleIndex = 0;
+							break;
+						}
+					}
+
+					float L = source.clip->mData[offset + i + 0];
+					float R = source.clip->mData[offset + i + 1];
+
+					L *= DecibelToLinear(source.volume);
+					R *= DecibelToLinear(source.volume);
+
+					mixBuffer[i + 0] += static_cast<int16>(L * 32767.0f);
+					mixBuffer[i + 1] += static_cast<int16>(R * 32767.0f);
+
+					source.sampleIndex += 1;
+				}
+			});
+
+			audioDevice->SetBuffer(&mixBuffer[0], byteToLock, bytesToWrite);
+		}
+	});
+
+	// ================================================================
+	// PHYSICS SYSTEM
+	// ================================================================
+
+	// Creating the group reorders its pools, so it must exist before the job runs on a worker thread.
+	world.GetGroup<Transform, Rigidbody>();
+
+	scheduler.Add<Writes<Transform, Rigidbody>>("Physics", [](World& world)
+	{
+		const float dt = GTime.GetDeltaTime();
+
+		world.GetGroup<Transform, Rigidbody>().ParallelEach([dt](Entity e, Transform& tr, Rigidbody& rb)
+		{
+			rb.linearAcceleration += rb.force * rb.inverseMass;
+			rb.linearVelocity += rb.linearAcceleration * dt;
+			rb.position += rb.linearVelocity * dt;
+			rb.force = 0.0f;
+			tr.translation = rb.position;
+
+			//Quaternion Integrate(const Quaternion& rotation, const Vector3& dv, float dt) {
+			//	return (rotation + 0.5f * dt * Quaternion(dv) * rotation).Normalize();
+			//}
+			//Vector3 angularAcceleration = rb.inverseInertiaTensor * rb.torque;
+			//rb.angularVelocity += rb.angularAcceleration * dt;
+			//rotation = Integrate(rotation, angularVelocity, dt);
+			//rb.torque = 0.0f;
+		});
+	});
+}
+
 void Update()
 {
 	glClearColor(0.3f, 0.3f, 0.3f, 1.0f);
@@ -312,116 +423,75 @@ void Update()
 
 	glBindVertexArray(VAO);
 
-	float dt = GTime.GetDeltaTime();
+	scheduler.Run(world);
 
 	// ================================================================
-	// AUDIO SYSTEM
+	// RENDER SYSTEM
 	// ================================================================
 
-	int byteToLock;
-	int bytesToWrite;
+	// Only rebuild the model matrices and bounds of entities of which the transform or mesh changed since the last frame.
 
-	audioDevice->GetPosition(byteToLock, bytesToWrite);
+	const Matrix3x4 axisConversion(cMatrix);
 
-	if (bytesToWrite)
+	auto updateModel = [&](Entity e, const Transform& transform, const StaticMesh& staticMesh)
 	{
-		// Samples, counts one for L and R together.
-		int samplesToWrite = bytesToWrite / 4; // Divided by BytesPerSample.
-
-		std::vector<int16> mixBuffer(samplesToWrite * 2, 0);
+		const uint32 index = EntityIndex(e);
 
-		auto aview = world.GetView<AudioSource>();
-
-		for (Entity e : aview)
+		if (!(index < modelMatrices.size()))
 		{
-			AudioSource& source = aview.Get<AudioSource>(e);
-
-			if (!source.isPlaying) continue;
-
-			int offset = source.sampleIndex * 2;
-
-			for (int i = 0; i < samplesToWrite * 2; i += 2)
-			{
-				if (source.sampleIndex >= source.clip->mSampleCount)
-				{
-					if (source.repeat)
-					{
-						source.sampleIndex = 0;
-						offset = 0;
-					}
-					else
-					{
-						source.isPlaying = false;
-						source.sampleIndex = 0;
-						break;
-					}
-				}
+			modelMatrices.resize(index + 1);
+			modelBounds.resize(index + 1);
+		}
 
-				float L = source.clip->mData[offset + i + 0];
-				float R = source.clip->mData[offset + i + 1];
+		modelMatrices[index] = Matrix3x4(Math::Transformation(transform.translation, transform.rotation, transform.scale)) * axisConversion;
+		modelBounds[index] = Math::Transformed(modelMatrices[index], staticMesh.mesh->mBoundingSphere);
+	};
 
-				L *= DecibelToLinear(source.volume);
-				R *= DecibelToLinear(source.volume);
+	world.GetView<const Transform, const StaticMesh>().EachChanged<const Transform>(renderTick, updateModel);
+	world.GetView<const Transform, const StaticMesh>().EachChanged<const StaticMesh>(renderTick, updateModel);
 
-				mixBuffer[i + 0] += static_cast<int16>(L * 32767.0f);
-				mixBuffer[i + 1] += static_cast<int16>(R * 32767.0f);
+	renderTick = world.GetTick();
 
-				source.sampleIndex += 1;
-			}
-		}
+	// Draw in mesh order, so consecutive draws of the same mesh share their buffer bindings.
+	// The pool stays sorted between frames, which makes the insertion sort close to free.
 
-		audioDevice->SetBuffer(&mixBuffer[0], byteToLock, bytesToWrite);
-	}
+	world.Sort<StaticMesh>([](const StaticMesh& lhs, const StaticMesh& rhs) { return lhs.mesh < rhs.mesh; }, ESortAlgorithm::Insertion);
 
-	// ================================================================
-	// PHYSICS SYSTEM
-	// ================================================================
+	// Gather the bounds in draw order and cull them against the view frustum in one batch.
 
-	auto pview = world.GetView<Transform, Rigidbody>();
+	cullSpheres.clear();
+	cullEntities.clear();
+	cullMeshes.clear();
 
-	for (Entity e : pview)
+	world.GetView<const Transform, const StaticMesh>().Use<const StaticMesh>().Each([&](Entity e, const Transform& transform, const StaticMesh& staticMesh)
 	{
-		Transform& tr = pview.Get<Transform>(e);
-		Rigidbody& rb = pview.Get<Rigidbody>(e);
-		
-		rb.linearAcceleration += rb.force * rb.inverseMass;
-		rb.linearVelocity += rb.linearAcceleration * dt;
-		rb.position += rb.linearVelocity * dt;
-		rb.force = 0.0f;
-		tr.translation = rb.position;
-
-		//Quaternion Integrate(const Quaternion& rotation, const Vector3& dv, float dt) {
-		//	return (rotation + 0.5f * dt * Quaternion(dv) * rotation).Normalize();
-		//}
-		//Vector3 angularAcceleration = rb.inverseInertiaTensor * rb.torque;
-		//rb.angularVelocity += rb.angularAcceleration * dt;
-		//rotation = Integrate(rotation, angularVelocity, dt);
-		//rb.torque = 0.0f;
-	}
+		cullSpheres.push_back(modelBounds[EntityIndex(e)]);
+		cullEntities.push_back(e);
+		cullMeshes.push_back(staticMesh.mesh);
+	});
 
-	// ================================================================
-	// RENDER SYSTEM
-	// ================================================================
+	visible.resize(cullSpheres.size());
 
-	auto cview = world.GetView<Transform, StaticMesh>();
-
-	for (Entity e : cview)
-	{
-		Transform& transform = cview.Get<Transform>(e);
-		StaticMesh& staticMesh = cview.Get<StaticMesh>(e);
+	const usize visibleCount = Math::CullSpheres(Frustum(projection * view), cullSpheres.data(), cullSpheres.size(), visible.data());
 
-		// TODO: This won't work for some reason.
-		//auto& [transform, staticMesh] = cview.Get<Transform, StaticMesh>(entity);
+	const Mesh* boundMesh = nullptr;
 
-		Matrix4 model = Math::Transformation(transform.translation, transform.rotation, transform.scale);
+	for (usize i = 0; i < visibleCount; i++)
+	{
+		const Mesh* mesh = cullMeshes[visible[i]];
 
-		bufferVertex.model = model * cMatrix;
+		bufferVertex.model = modelMatrices[EntityIndex(cullEntities[visible[i]])];
 
 		uboVertex.Update(&bufferVertex);
 
-		glBindVertexBuffer(0, staticMesh.mesh->vertexBuffer, 0, sizeof(Mesh::Vertex));
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, staticMesh.mesh->indexBuffer);
+		if (mesh != boundMesh)
+		{
+			glBindVertexBuffer(0, mesh->vertexBuffer, 0, sizeof(Mesh::Vertex));
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->indexBuffer);
+
+			boundMesh = mesh;
+		}
 
-		glDrawElements(GL_TRIANGLES, staticMesh.mesh->mIndices.size(), GL_UNSIGNED_INT, 0);
+		glDrawElements(GL_TRIANGLES, mesh->mIndices.size(), GL_UNSIGNED_INT, 0);
 	}
 }
@@ -0,0 +1,80 @@
+// Copyright (c) 2020 Lauro Oyen, FmEngine contributors. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md for full terms. This notice is not to be removed.
+
+#include "MappedFile.h"
+
+#include "../../Utility/Logger/Log.h"
+
+#include <windows.h>
+
+namespace FM
+{
+	bool MappedFile::Open(const char* filepath)
+	{
+		Close();
+
+		HANDLE file = CreateFileA(filepath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			const DWORD error = GetLastError();
+			FM_LOG(Error) << "Failed to open file " << filepath << ", error " << error;
+			return false;
+		}
+
+		mFile = file;
+
+		LARGE_INTEGER size;
+
+		if (!GetFileSizeEx(file, &size))
+		{
+			const DWORD error = GetLastError();
+			FM_LOG(Error) << "Failed to get the size of file " << filepath << ", error " << error;
+			Close();
+			return false;
+		}
+
+		if (size.QuadPart == 0)
+		{
+			FM_LOG(Error) << "Failed to map empty file " << filepath;
+			Close();
+			return false;
+		}
+
+		mMapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+
+		if (!mMapping)
+		{
+			const DWORD error = GetLastError();
+			FM_LOG(Error) << "Failed to create file mapping of " << filepath << ", error " << error;
+			Close();
+			return false;
+		}
+
+		mData = MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0);
+
+		if (!mData)
+		{
+			const DWORD error = GetLastError();
+			FM_LOG(Error) << "Failed to map view of " << filepath << ", error " << error;
+			Close();
+			return false;
+		}
+
+		mSize = static_cast<usize>(size.QuadPart);
+
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if (mData) UnmapViewOfFile(mData);
+		if (mMapping) CloseHandle(mMapping);
+		if (mFile) CloseHandle(mFile);
+
+		mFile = nullptr;
+		mMapping = nullptr;
+		mData = nullptr;
+		mSize = 0;
+	}
+}
@@ -0,0 +1,41 @@
+// Copyright (c) 2020 Lauro Oyen, FmEngine contributors. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md for full terms. This notice is not to be removed.
+
+#pragma once
+
+#include "../../Utility/CoreTypes.h"
+
+namespace FM
+{
+	/// Read-only view of a whole file mapped into memory.
+	/// Pages are loaded by the OS on first access, the view is page aligned.
+
+	class MappedFile
+	{
+	public:
+
+		MappedFile() = default;
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		~MappedFile()
+		{
+			Close();
+		}
+
+		bool Open(const char* filepath);
+
+		void Close();
+
+		const void* Data() const { return mData; }
+		usize Size() const { return mSize; }
+
+	private:
+
+		void* mFile = nullptr;
+		void* mMapping = nullptr;
+		const void* mData = nullptr;
+		usize mSize = 0;
+	};
+}
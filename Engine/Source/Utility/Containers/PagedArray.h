@@ -0,0 +1,218 @@
+// Copyright (c) 2020 Lauro Oyen, FmEngine contributors. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md for full terms. This notice is not to be removed.
+
+#pragma once
+
+#include "../CoreTypes.h"
+#include "../Memory.h"
+
+#include <algorithm>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace FM
+{
+	/// Dynamic array that stores its elements in fixed size pages.
+	/// Pages are never relocated, so growing the array doesn't move existing elements: pointers and references
+	/// stay valid until the element itself is removed, and there is no copy spike when the capacity is exceeded.
+	/// Mirrors the part of the std::vector interface that is used by the engine containers.
+
+	template <typename T, usize PageSize = 1024>
+	class TPagedArray
+	{
+		static_assert(PageSize > 0 && (PageSize & (PageSize - 1)) == 0, "Page size must be a power of two.");
+
+	public:
+
+		static constexpr usize ElementsPerPage = PageSize;
+
+		TPagedArray() = default;
+
+		TPagedArray(const TPagedArray& other)
+		{
+			append_all(other);
+		}
+
+		TPagedArray(TPagedArray&& other) noexcept
+			: mPages(std::move(other.mPages)), mSize(other.mSize)
+		{
+			other.mSize = 0;
+		}
+
+		~TPagedArray()
+		{
+			clear();
+		}
+
+		TPagedArray& operator=(const TPagedArray& other)
+		{
+			if (this != &other)
+			{
+				clear();
+				append_all(other);
+			}
+
+			return *this;
+		}
+
+		TPagedArray& operator=(TPagedArray&& other) noexcept
+		{
+			if (this != &other)
+			{
+				clear();
+				mPages = std::move(other.mPages);
+				mSize = other.mSize;
+				other.mSize = 0;
+			}
+
+			return *this;
+		}
+
+		usize size() const {
+			return mSize;
+		}
+
+		bool empty() const {
+			return mSize == 0;
+		}
+
+		usize capacity() const {
+			return mPages.size() * PageSize;
+		}
+
+		T& operator[](usize index) {
+			return mPages[index / PageSize][index % PageSize];
+		}
+
+		const T& operator[](usize index) const {
+			return mPages[index / PageSize][index % PageSize];
+		}
+
+		T& back() {
+			return (*this)[mSize - 1];
+		}
+
+		const T& back() const {
+			return (*this)[mSize - 1];
+		}
+
+		/// Returns the first element of a page, the elements of a page are contiguous.
+		T* page(usize page) {
+			return mPages[page].get();
+		}
+
+		const T* page(usize page) const {
+			return mPages[page].get();
+		}
+
+		/// Allocates pages until there is room for at least the given number of elements.
+		void reserve(usize count)
+		{
+			while (capacity() < count)
+			{
+				mPages.emplace_back(static_cast<T*>(::operator new(sizeof(T) * PageSize, std::align_val_t(alignof(T)))));
+			}
+		}
+
+		template <typename... Args>
+		T& emplace_back(Args&&... args)
+		{
+			reserve(mSize + 1);
+
+			T* element = new (&mPages[mSize / PageSize][mSize % PageSize]) T(std::forward<Args>(args)...);
+			mSize++;
+
+			return *element;
+		}
+
+		void push_back(const T& value) {
+			emplace_back(value);
+		}
+
+		void push_back(T&& value) {
+			emplace_back(std::move(value));
+		}
+
+		void pop_back()
+		{
+			mSize--;
+			mPages[mSize / PageSize][mSize % PageSize].~T();
+		}
+
+		/// Removes elements from the back or appends copies of the value until the array has count elements.
+		void resize(usize count, const T& value)
+		{
+			reserve(count);
+
+			while (mSize > count) pop_back();
+			while (mSize < count) emplace_back(value);
+		}
+
+		/// Appends count elements copied from the array, page by page with memcpy for trivially copyable types.
+		void append(const T* values, usize count)
+		{
+			reserve(mSize + count);
+
+			if constexpr (std::is_trivially_copyable_v<T>)
+			{
+				while (count > 0)
+				{
+					const usize n = std::min(count, PageSize - mSize % PageSize);
+
+					Memory::Memcpy(&mPages[mSize / PageSize][mSize % PageSize], values, n * sizeof(T));
+
+					mSize += n;
+					values += n;
+					count -= n;
+				}
+			}
+			else
+			{
+				for (usize i = 0; i < count; i++)
+				{
+					emplace_back(values[i]);
+				}
+			}
+		}
+
+		/// Destroys all elements, the pages are kept.
+		void clear()
+		{
+			if constexpr (!std::is_trivially_destructible_v<T>)
+			{
+				for (usize i = 0; i < mSize; i++)
+				{
+					(*this)[i].~T();
+				}
+			}
+
+			mSize = 0;
+		}
+
+	private:
+
+		/// Appends the elements of the other array page by page, the pages of this array are reused.
+		void append_all(const TPagedArray& other)
+		{
+			reserve(mSize + other.mSize);
+
+			for (usize first = 0; first < other.mSize; first += PageSize)
+			{
+				append(other.page(first / PageSize), std::min(PageSize, other.mSize - first));
+			}
+		}
+
+		struct PageDeleter
+		{
+			void operator()(T* page) const {
+				::operator delete(page, std::align_val_t(alignof(T)));
+			}
+		};
+
+		std::vector<std::unique_ptr<T[], PageDeleter>> mPages;
+		usize mSize = 0;
+	};
+}
@@ -0,0 +1,78 @@
+// Copyright (c) 2020 Lauro Oyen, FmEngine contributors. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md for full terms. This notice is not to be removed.
+
+#pragma once
+
+#include "Vector.h"
+#include "Matrix.h"
+
+namespace FM
+{
+	/// Axis aligned bounding box.
+
+	template <typename T>
+	struct TBoundingBox
+	{
+		TVector3<T> min = T(0);
+		TVector3<T> max = T(0);
+
+		constexpr TBoundingBox() = default;
+
+		constexpr TBoundingBox(const TVector3<T>& min, const TVector3<T>& max)
+			: min(min), max(max) {}
+
+		constexpr TVector3<T> Center() const { return (min + max) / T(2); }
+		constexpr TVector3<T> Extents() const { return (max - min) / T(2); }
+	};
+
+	/// Bounding sphere, laid out as 4 consecutive values so arrays of spheres can be loaded into SIMD registers.
+
+	template <typename T>
+	struct TBoundingSphere
+	{
+		TVector3<T> center = T(0);
+		T radius = T(0);
+
+		constexpr TBoundingSphere() = default;
+
+		constexpr TBoundingSphere(const TVector3<T>& center, T radius)
+			: center(center), radius(radius) {}
+	};
+
+	// Type aliases
+
+	using BoundingBox = TBoundingBox<float>;
+	using BoundingSphere = TBoundingSphere<float>;
+
+	// Calculations
+
+	namespace Math
+	{
+		/// Grows the box to contain the point.
+		template <typename T>
+		constexpr void Enclose(TBoundingBox<T>& box, const TVector3<T>& p)
+		{
+			for (int i = 0; i < 3; i++)
+			{
+				if (p[i] < box.min[i]) box.min[i] = p[i];
+				if (p[i] > box.max[i]) box.max[i] = p[i];
+			}
+		}
+
+		/// Bounding sphere of a transformed sphere. The matrix may contain non-uniform scale but no shear,
+		/// the radius is scaled by the largest scale factor, which is the length of the longest column.
+		template <typename T>
+		TBoundingSphere<T> Transformed(const TMatrix3x4<T>& m, const TBoundingSphere<T>& sphere)
+		{
+			T scale = T(0);
+
+			for (int c = 0; c < 3; c++)
+			{
+				const T lengthSquared = m(0, c) * m(0, c) + m(1, c) * m(1, c) + m(2, c) * m(2, c);
+				if (lengthSquared > scale) scale = lengthSquared;
+			}
+
+			return TBoundingSphere<T>(TransformPoint(m, sphere.center), sphere.radius * Sqrt(scale));
+		}
+	}
+}
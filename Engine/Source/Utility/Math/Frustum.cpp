@@ -0,0 +1,77 @@
+// Copyright (c) 2020 Lauro Oyen, FmEngine contributors. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md for full terms. This notice is not to be removed.
+
+#include "Frustum.h"
+
+#include <xmmintrin.h>
+#include <emmintrin.h>
+
+namespace FM
+{
+	namespace Math
+	{
+		static_assert(sizeof(BoundingSphere) == 4 * sizeof(float), "BoundingSphere is expected to be tightly packed.");
+
+		usize CullSpheres(const Frustum& frustum, const BoundingSphere* spheres, usize count, uint32* visible)
+		{
+			__m128 nx[6], ny[6], nz[6], distance[6];
+
+			for (int i = 0; i < 6; i++)
+			{
+				nx[i] = _mm_set1_ps(frustum.planes[i].normal.x);
+				ny[i] = _mm_set1_ps(frustum.planes[i].normal.y);
+				nz[i] = _mm_set1_ps(frustum.planes[i].normal.z);
+				distance[i] = _mm_set1_ps(frustum.planes[i].distance);
+			}
+
+			usize visibleCount = 0;
+			usize i = 0;
+
+			for (; i + 4 <= count; i += 4)
+			{
+				// Transpose the spheres into lanes.
+
+				__m128 x = _mm_loadu_ps(&spheres[i + 0].center.x);
+				__m128 y = _mm_loadu_ps(&spheres[i + 1].center.x);
+				__m128 z = _mm_loadu_ps(&spheres[i + 2].center.x);
+				__m128 r = _mm_loadu_ps(&spheres[i + 3].center.x);
+				_MM_TRANSPOSE4_PS(x, y, z, r);
+
+				const __m128 negR = _mm_sub_ps(_mm_setzero_ps(), r);
+
+				// A sphere is visible as long as it isn't entirely behind one of the planes.
+				// Uses not-less-than, so NaN compares the same way as in Frustum::Intersects().
+
+				__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+				for (int p = 0; p < 6; p++)
+				{
+					__m128 d = _mm_mul_ps(nx[p], x);
+					d = _mm_add_ps(d, _mm_mul_ps(ny[p], y));
+					d = _mm_add_ps(d, _mm_mul_ps(nz[p], z));
+					d = _mm_sub_ps(d, distance[p]);
+
+					inside = _mm_and_ps(inside, _mm_cmpnlt_ps(d, negR));
+				}
+
+				// Compact the visible lanes without branches, every lane is written but only kept if visible.
+
+				const int mask = _mm_movemask_ps(inside);
+
+				for (uint32 j = 0; j < 4; j++)
+				{
+					visible[visibleCount] = static_cast<uint32>(i) + j;
+					visibleCount += (mask >> j) & 1;
+				}
+			}
+
+			for (; i < count; i++)
+			{
+				visible[visibleCount] = static_cast<uint32>(i);
+				visibleCount += frustum.Intersects(spheres[i]);
+			}
+
+			return visibleCount;
+		}
+	}
+}
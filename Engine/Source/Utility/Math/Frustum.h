@@ -0,0 +1,75 @@
+// Copyright (c) 2020 Lauro Oyen, FmEngine contributors. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md for full terms. This notice is not to be removed.
+
+#pragma once
+
+#include "../CoreTypes.h"
+#include "Vector.h"
+#include "Matrix.h"
+#include "Plane.h"
+#include "Bounds.h"
+
+namespace FM
+{
+	/// View frustum bounded by six planes, of which the normals point inwards.
+	/// The planes are stored in the order left, right, bottom, top, near, far.
+
+	template <typename T>
+	struct TFrustum
+	{
+		TPlane<T> planes[6];
+
+		TFrustum() = default;
+
+		/// Extracts the planes from the rows of a view-projection matrix that transforms column vectors to a clip space
+		/// with a depth range of [0, 1], as produced by Math::Perspective() and Math::Orthographic().
+		explicit TFrustum(const TMatrix4<T>& viewProjection)
+		{
+			const TMatrix4<T>& m = viewProjection;
+
+			SetPlane(0, m(3, 0) + m(0, 0), m(3, 1) + m(0, 1), m(3, 2) + m(0, 2), m(3, 3) + m(0, 3));
+			SetPlane(1, m(3, 0) - m(0, 0), m(3, 1) - m(0, 1), m(3, 2) - m(0, 2), m(3, 3) - m(0, 3));
+			SetPlane(2, m(3, 0) + m(1, 0), m(3, 1) + m(1, 1), m(3, 2) + m(1, 2), m(3, 3) + m(1, 3));
+			SetPlane(3, m(3, 0) - m(1, 0), m(3, 1) - m(1, 1), m(3, 2) - m(1, 2), m(3, 3) - m(1, 3));
+			SetPlane(4, m(2, 0), m(2, 1), m(2, 2), m(2, 3));
+			SetPlane(5, m(3, 0) - m(2, 0), m(3, 1) - m(2, 1), m(3, 2) - m(2, 2), m(3, 3) - m(2, 3));
+		}
+
+		/// Checks if the sphere lies at least partially inside the frustum.
+		/// Spheres near a corner, outside of the frustum but not entirely behind any plane, are reported as inside.
+		bool Intersects(const TBoundingSphere<T>& sphere) const
+		{
+			for (const TPlane<T>& plane : planes)
+			{
+				if (Math::Dot(plane.normal, sphere.center) - plane.distance < -sphere.radius) return false;
+			}
+
+			return true;
+		}
+
+	private:
+
+		/// Sets a plane from the equation ax + by + cz + d >= 0 for points inside the frustum.
+		void SetPlane(int i, T a, T b, T c, T d)
+		{
+			const T length = Math::Length(TVector3<T>(a, b, c));
+
+			planes[i].normal = TVector3<T>(a, b, c) / length;
+			planes[i].distance = -d / length;
+		}
+	};
+
+	// Type aliases
+
+	using Frustum = TFrustum<float>;
+
+	// Calculations
+
+	namespace Math
+	{
+		/// Writes the indices of the spheres that intersect the frustum to visible, in ascending order, and returns their count.
+		/// Four spheres are tested at a time with SSE, with the same results as Frustum::Intersects().
+		/// The visible array must have room for count indices.
+		usize CullSpheres(const Frustum& frustum, const BoundingSphere* spheres, usize count, uint32* visible);
+	}
+}
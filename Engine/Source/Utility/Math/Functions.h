@@ -47,8 +47,8 @@ namespace FM
 		template <typename T>
 		T UnwindRadians(T radians)
 		{
-			while (radians > Pi<T>) radians -= TwoPi<T>;
-			while (radians < -Pi<T>) radians += TwoPi<T>;
+			while (radians > Pi<T>) radians -= Tau<T>;
+			while (radians < -Pi<T>) radians += Tau<T>;
 			return radians;
 		}
 
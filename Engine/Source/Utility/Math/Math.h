@@ -11,7 +11,13 @@
 #include "Matrix.h"
 #include "Quaternion.h"
 
+#include "Vector4A.h"
+#include "Matrix4A.h"
+#include "Wide.h"
+
 #include "Plane.h"
+#include "Bounds.h"
+#include "Frustum.h"
 
 #include "Rectangle.h"
 
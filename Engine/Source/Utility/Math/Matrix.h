@@ -168,9 +168,43 @@ namespace FM
 	template <typename T> using TMatrix3 = TMatrix<T, 3, 3>;
 	template <typename T> using TMatrix4 = TMatrix<T, 4, 4>;
 
+	/// Affine transformation, a 4x4 matrix of which the implied bottom row is [0, 0, 0, 1].
+	/// Converts to and from TMatrix4 by dropping or restoring that row.
+	template <typename T> using TMatrix3x4 = TMatrix<T, 3, 4>;
+
 	using Matrix2 = TMatrix2<float>;
 	using Matrix3 = TMatrix3<float>;
 	using Matrix4 = TMatrix4<float>;
+	using Matrix3x4 = TMatrix3x4<float>;
+
+	// Affine operators
+
+	/// Product of two affine transformations, as if both were 4x4 matrices.
+	template <typename T>
+	inline constexpr TMatrix3x4<T> operator* (const TMatrix3x4<T>& lhs, const TMatrix3x4<T>& rhs)
+	{
+		TMatrix3x4<T> r;
+
+		for (int row = 0; row < 3; row++)
+		{
+			for (int col = 0; col < 4; col++)
+			{
+				for (int i = 0; i < 3; i++)
+				{
+					r(row, col) += lhs(row, i) * rhs(i, col);
+				}
+			}
+
+			r(row, 3) += lhs(row, 3);
+		}
+
+		return r;
+	}
+
+	template <typename T>
+	inline constexpr TMatrix3x4<T> operator*= (TMatrix3x4<T>& lhs, const TMatrix3x4<T>& rhs) {
+		return lhs = lhs * rhs;
+	}
 
 	// Calculations
 
@@ -309,5 +343,46 @@ namespace FM
 				m41 * invDet, m42 * invDet, m43 * invDet, m44 * invDet
 			);
 		}
+
+		/// Inverse of an affine transformation, the inverse of the 3x3 part followed by the inverse translation.
+		/// The 3x3 part must be invertible.
+		template<typename T>
+		constexpr TMatrix3x4<T> Inverted(const TMatrix3x4<T>& m)
+		{
+			const TMatrix3<T> a = Inverted(TMatrix3<T>(m));
+
+			TMatrix3x4<T> r(a);
+
+			for (int row = 0; row < 3; row++)
+			{
+				r(row, 3) = -(a(row, 0) * m(0, 3) + a(row, 1) * m(1, 3) + a(row, 2) * m(2, 3));
+			}
+
+			return r;
+		}
+
+		/// Transforms a point, the translation is applied.
+		template <typename T>
+		constexpr TVector3<T> TransformPoint(const TMatrix3x4<T>& m, const TVector3<T>& p)
+		{
+			return TVector3<T>
+			(
+				m(0, 0) * p.x + m(0, 1) * p.y + m(0, 2) * p.z + m(0, 3),
+				m(1, 0) * p.x + m(1, 1) * p.y + m(1, 2) * p.z + m(1, 3),
+				m(2, 0) * p.x + m(2, 1) * p.y + m(2, 2) * p.z + m(2, 3)
+			);
+		}
+
+		/// Transforms a direction, the translation is ignored.
+		template <typename T>
+		constexpr TVector3<T> TransformVector(const TMatrix3x4<T>& m, const TVector3<T>& v)
+		{
+			return TVector3<T>
+			(
+				m(0, 0) * v.x + m(0, 1) * v.y + m(0, 2) * v.z,
+				m(1, 0) * v.x + m(1, 1) * v.y + m(1, 2) * v.z,
+				m(2, 0) * v.x + m(2, 1) * v.y + m(2, 2) * v.z
+			);
+		}
 	}
 }
@@ -0,0 +1,214 @@
+// Copyright (c) 2020 Lauro Oyen, FmEngine contributors. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md for full terms. This notice is not to be removed.
+
+#pragma once
+
+#include "../CoreTypes.h"
+#include "Matrix.h"
+#include "Vector4A.h"
+
+namespace FM
+{
+	/// 4x4 float matrix in a row-major format, every row is stored in an SSE register.
+	/// Aligned counterpart of Matrix4 for hot paths. Products and transposes give the same results as those of Matrix4,
+	/// the inverse is computed with a different order of operations and may differ in rounding.
+
+	struct alignas(16) Matrix4A
+	{
+		Vector4A rows[4];
+
+		Matrix4A() = default;
+
+		Matrix4A(const Vector4A& r0, const Vector4A& r1, const Vector4A& r2, const Vector4A& r3)
+			: rows{ r0, r1, r2, r3 } {}
+
+		Matrix4A(const Matrix4& other)
+			: rows{ Vector4A(_mm_loadu_ps(&other.m[0][0])), Vector4A(_mm_loadu_ps(&other.m[1][0])), Vector4A(_mm_loadu_ps(&other.m[2][0])), Vector4A(_mm_loadu_ps(&other.m[3][0])) } {}
+
+		operator Matrix4() const
+		{
+			Matrix4 r;
+			Store(r.data);
+			return r;
+		}
+
+		/// Writes the 16 floats in row-major order, the destination doesn't have to be aligned.
+		void Store(float* dst) const
+		{
+			for (int i = 0; i < 4; i++) _mm_storeu_ps(dst + i * 4, rows[i].v);
+		}
+
+		float operator() (usize row, usize col) const {
+			return rows[row][col];
+		}
+
+		static const Matrix4A Identity;
+	};
+
+	// Standard matrices
+
+	inline const Matrix4A Matrix4A::Identity(Vector4A(1, 0, 0, 0), Vector4A(0, 1, 0, 0), Vector4A(0, 0, 1, 0), Vector4A(0, 0, 0, 1));
+
+	// Arithmetic operators
+
+	inline Matrix4A operator+ (const Matrix4A& lhs, const Matrix4A& rhs)
+	{
+		return Matrix4A(lhs.rows[0] + rhs.rows[0], lhs.rows[1] + rhs.rows[1], lhs.rows[2] + rhs.rows[2], lhs.rows[3] + rhs.rows[3]);
+	}
+
+	inline Matrix4A operator- (const Matrix4A& lhs, const Matrix4A& rhs)
+	{
+		return Matrix4A(lhs.rows[0] - rhs.rows[0], lhs.rows[1] - rhs.rows[1], lhs.rows[2] - rhs.rows[2], lhs.rows[3] - rhs.rows[3]);
+	}
+
+	inline Matrix4A operator* (const Matrix4A& lhs, float rhs)
+	{
+		return Matrix4A(lhs.rows[0] * rhs, lhs.rows[1] * rhs, lhs.rows[2] * rhs, lhs.rows[3] * rhs);
+	}
+
+	/// Every row of the result is a linear combination of the rows of rhs, summed in the same order as the generic product.
+	inline Matrix4A operator* (const Matrix4A& lhs, const Matrix4A& rhs)
+	{
+		Matrix4A r;
+
+		for (int row = 0; row < 4; row++)
+		{
+			const __m128 l = lhs.rows[row].v;
+
+			__m128 sum = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(0, 0, 0, 0)), rhs.rows[0].v);
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(1, 1, 1, 1)), rhs.rows[1].v));
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(2, 2, 2, 2)), rhs.rows[2].v));
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(3, 3, 3, 3)), rhs.rows[3].v));
+
+			r.rows[row].v = sum;
+		}
+
+		return r;
+	}
+
+	/// Transforms a column vector.
+	inline Vector4A operator* (const Matrix4A& lhs, const Vector4A& rhs)
+	{
+		__m128 p0 = _mm_mul_ps(lhs.rows[0].v, rhs.v);
+		__m128 p1 = _mm_mul_ps(lhs.rows[1].v, rhs.v);
+		__m128 p2 = _mm_mul_ps(lhs.rows[2].v, rhs.v);
+		__m128 p3 = _mm_mul_ps(lhs.rows[3].v, rhs.v);
+
+		// Lane i of pj holds the product of row i and component j.
+		_MM_TRANSPOSE4_PS(p0, p1, p2, p3);
+
+		return Vector4A(_mm_add_ps(_mm_add_ps(_mm_add_ps(p0, p1), p2), p3));
+	}
+
+	// Assignment operators
+
+	inline Matrix4A& operator+= (Matrix4A& lhs, const Matrix4A& rhs) {
+		return lhs = lhs + rhs;
+	}
+
+	inline Matrix4A& operator-= (Matrix4A& lhs, const Matrix4A& rhs) {
+		return lhs = lhs - rhs;
+	}
+
+	inline Matrix4A& operator*= (Matrix4A& lhs, const Matrix4A& rhs) {
+		return lhs = lhs * rhs;
+	}
+
+	inline Matrix4A& operator*= (Matrix4A& lhs, float rhs) {
+		return lhs = lhs * rhs;
+	}
+
+	// Relational operators
+
+	inline bool operator== (const Matrix4A& lhs, const Matrix4A& rhs)
+	{
+		return lhs.rows[0] == rhs.rows[0] && lhs.rows[1] == rhs.rows[1] && lhs.rows[2] == rhs.rows[2] && lhs.rows[3] == rhs.rows[3];
+	}
+
+	// Calculations
+
+	namespace Math
+	{
+		inline Matrix4A Transpose(const Matrix4A& m)
+		{
+			__m128 r0 = m.rows[0].v, r1 = m.rows[1].v, r2 = m.rows[2].v, r3 = m.rows[3].v;
+			_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+			return Matrix4A(Vector4A(r0), Vector4A(r1), Vector4A(r2), Vector4A(r3));
+		}
+
+		/// Inverse by cofactors, computed on the transposed matrix four cofactors at a time.
+		/// The matrix must be invertible.
+		inline Matrix4A Inverted(const Matrix4A& m)
+		{
+			// Rows of the transpose, with the second and fourth row rotated by two lanes.
+			__m128 r0 = m.rows[0].v, r1 = m.rows[1].v, r2 = m.rows[2].v, r3 = m.rows[3].v;
+			_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+			r1 = _mm_shuffle_ps(r1, r1, _MM_SHUFFLE(1, 0, 3, 2));
+			r3 = _mm_shuffle_ps(r3, r3, _MM_SHUFFLE(1, 0, 3, 2));
+
+			__m128 tmp, c0, c1, c2, c3;
+
+			tmp = _mm_mul_ps(r2, r3);
+			tmp = _mm_shuffle_ps(tmp, tmp, _MM_SHUFFLE(2, 3, 0, 1));
+			c0 = _mm_mul_ps(r1, tmp);
+			c1 = _mm_mul_ps(r0, tmp);
+			tmp = _mm_shuffle_ps(tmp, tmp, _MM_SHUFFLE(1, 0, 3, 2));
+			c0 = _mm_sub_ps(_mm_mul_ps(r1, tmp), c0);
+			c1 = _mm_sub_ps(_mm_mul_ps(r0, tmp), c1);
+			c1 = _mm_shuffle_ps(c1, c1, _MM_SHUFFLE(1, 0, 3, 2));
+
+			tmp = _mm_mul_ps(r1, r2);
+			tmp = _mm_shuffle_ps(tmp, tmp, _MM_SHUFFLE(2, 3, 0, 1));
+			c0 = _mm_add_ps(_mm_mul_ps(r3, tmp), c0);
+			c3 = _mm_mul_ps(r0, tmp);
+			tmp = _mm_shuffle_ps(tmp, tmp, _MM_SHUFFLE(1, 0, 3, 2));
+			c0 = _mm_sub_ps(c0, _mm_mul_ps(r3, tmp));
+			c3 = _mm_sub_ps(_mm_mul_ps(r0, tmp), c3);
+			c3 = _mm_shuffle_ps(c3, c3, _MM_SHUFFLE(1, 0, 3, 2));
+
+			tmp = _mm_mul_ps(_mm_shuffle_ps(r1, r1, _MM_SHUFFLE(1, 0, 3, 2)), r3);
+			tmp = _mm_shuffle_ps(tmp, tmp, _MM_SHUFFLE(2, 3, 0, 1));
+			r2 = _mm_shuffle_ps(r2, r2, _MM_SHUFFLE(1, 0, 3, 2));
+			c0 = _mm_add_ps(_mm_mul_ps(r2, tmp), c0);
+			c2 = _mm_mul_ps(r0, tmp);
+			tmp = _mm_shuffle_ps(tmp, tmp, _MM_SHUFFLE(1, 0, 3, 2));
+			c0 = _mm_sub_ps(c0, _mm_mul_ps(r2, tmp));
+			c2 = _mm_sub_ps(_mm_mul_ps(r0, tmp), c2);
+			c2 = _mm_shuffle_ps(c2, c2, _MM_SHUFFLE(1, 0, 3, 2));
+
+			tmp = _mm_mul_ps(r0, r1);
+			tmp = _mm_shuffle_ps(tmp, tmp, _MM_SHUFFLE(2, 3, 0, 1));
+			c2 = _mm_add_ps(_mm_mul_ps(r3, tmp), c2);
+			c3 = _mm_sub_ps(_mm_mul_ps(r2, tmp), c3);
+			tmp = _mm_shuffle_ps(tmp, tmp, _MM_SHUFFLE(1, 0, 3, 2));
+			c2 = _mm_sub_ps(_mm_mul_ps(r3, tmp), c2);
+			c3 = _mm_sub_ps(c3, _mm_mul_ps(r2, tmp));
+
+			tmp = _mm_mul_ps(r0, r3);
+			tmp = _mm_shuffle_ps(tmp, tmp, _MM_SHUFFLE(2, 3, 0, 1));
+			c1 = _mm_sub_ps(c1, _mm_mul_ps(r2, tmp));
+			c2 = _mm_add_ps(_mm_mul_ps(r1, tmp), c2);
+			tmp = _mm_shuffle_ps(tmp, tmp, _MM_SHUFFLE(1, 0, 3, 2));
+			c1 = _mm_add_ps(_mm_mul_ps(r2, tmp), c1);
+			c2 = _mm_sub_ps(c2, _mm_mul_ps(r1, tmp));
+
+			tmp = _mm_mul_ps(r0, r2);
+			tmp = _mm_shuffle_ps(tmp, tmp, _MM_SHUFFLE(2, 3, 0, 1));
+			c1 = _mm_add_ps(_mm_mul_ps(r3, tmp), c1);
+			c3 = _mm_sub_ps(c3, _mm_mul_ps(r1, tmp));
+			tmp = _mm_shuffle_ps(tmp, tmp, _MM_SHUFFLE(1, 0, 3, 2));
+			c1 = _mm_sub_ps(c1, _mm_mul_ps(r3, tmp));
+			c3 = _mm_add_ps(_mm_mul_ps(r1, tmp), c3);
+
+			// The determinant is the dot product of the first row of the transpose and its cofactors.
+			__m128 det = _mm_mul_ps(r0, c0);
+			det = _mm_add_ps(_mm_shuffle_ps(det, det, _MM_SHUFFLE(1, 0, 3, 2)), det);
+			det = _mm_add_ss(_mm_shuffle_ps(det, det, _MM_SHUFFLE(2, 3, 0, 1)), det);
+			det = _mm_div_ss(_mm_set_ss(1.0f), det);
+			det = _mm_shuffle_ps(det, det, _MM_SHUFFLE(0, 0, 0, 0));
+
+			return Matrix4A(Vector4A(_mm_mul_ps(c0, det)), Vector4A(_mm_mul_ps(c1, det)), Vector4A(_mm_mul_ps(c2, det)), Vector4A(_mm_mul_ps(c3, det)));
+		}
+	}
+}
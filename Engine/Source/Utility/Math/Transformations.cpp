@@ -0,0 +1,134 @@
+// Copyright (c) 2020 Lauro Oyen, FmEngine contributors. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md for full terms. This notice is not to be removed.
+
+#include "Transformations.h"
+
+#include <xmmintrin.h>
+
+namespace FM
+{
+	namespace Math
+	{
+		static_assert(sizeof(Transform) == 10 * sizeof(float), "Transform is expected to be tightly packed.");
+
+		/// Computes the top three rows of the matrices of four transforms, row r of transform j is written to rows[j * 3 + r].
+		/// Uses the same operations in the same order as Transformation(), so the results are identical.
+		static void TransformationRows(const Transform* src, __m128 rows[12])
+		{
+			// Transpose the transforms into lanes. Every load stays within the transform: the scale is loaded together
+			// with the w component of the rotation in front of it.
+
+			__m128 tx = _mm_loadu_ps(&src[0].translation.x);
+			__m128 ty = _mm_loadu_ps(&src[1].translation.x);
+			__m128 tz = _mm_loadu_ps(&src[2].translation.x);
+			__m128 tw = _mm_loadu_ps(&src[3].translation.x);
+			_MM_TRANSPOSE4_PS(tx, ty, tz, tw);
+
+			__m128 qx = _mm_loadu_ps(&src[0].rotation.x);
+			__m128 qy = _mm_loadu_ps(&src[1].rotation.x);
+			__m128 qz = _mm_loadu_ps(&src[2].rotation.x);
+			__m128 qw = _mm_loadu_ps(&src[3].rotation.x);
+			_MM_TRANSPOSE4_PS(qx, qy, qz, qw);
+
+			__m128 sw = _mm_loadu_ps(&src[0].rotation.w);
+			__m128 sx = _mm_loadu_ps(&src[1].rotation.w);
+			__m128 sy = _mm_loadu_ps(&src[2].rotation.w);
+			__m128 sz = _mm_loadu_ps(&src[3].rotation.w);
+			_MM_TRANSPOSE4_PS(sw, sx, sy, sz);
+
+			const __m128 one = _mm_set1_ps(1.0f);
+
+			const __m128 x2 = _mm_add_ps(qx, qx);
+			const __m128 y2 = _mm_add_ps(qy, qy);
+			const __m128 z2 = _mm_add_ps(qz, qz);
+			const __m128 x2w = _mm_mul_ps(x2, qw);
+			const __m128 y2w = _mm_mul_ps(y2, qw);
+			const __m128 z2w = _mm_mul_ps(z2, qw);
+			const __m128 x2x = _mm_mul_ps(x2, qx);
+			const __m128 y2x = _mm_mul_ps(y2, qx);
+			const __m128 z2x = _mm_mul_ps(z2, qx);
+			const __m128 y2y = _mm_mul_ps(y2, qy);
+			const __m128 z2y = _mm_mul_ps(z2, qy);
+			const __m128 z2z = _mm_mul_ps(z2, qz);
+
+			__m128 m00 = _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(y2y, z2z)), sx);
+			__m128 m01 = _mm_mul_ps(_mm_sub_ps(y2x, z2w), sy);
+			__m128 m02 = _mm_mul_ps(_mm_add_ps(z2x, y2w), sz);
+			__m128 m03 = tx;
+
+			__m128 m10 = _mm_mul_ps(_mm_add_ps(y2x, z2w), sx);
+			__m128 m11 = _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(x2x, z2z)), sy);
+			__m128 m12 = _mm_mul_ps(_mm_sub_ps(z2y, x2w), sz);
+			__m128 m13 = ty;
+
+			__m128 m20 = _mm_mul_ps(_mm_sub_ps(z2x, y2w), sx);
+			__m128 m21 = _mm_mul_ps(_mm_add_ps(z2y, x2w), sy);
+			__m128 m22 = _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(x2x, y2y)), sz);
+			__m128 m23 = tz;
+
+			// Transpose back, so every register holds a row of one matrix.
+
+			_MM_TRANSPOSE4_PS(m00, m01, m02, m03);
+			_MM_TRANSPOSE4_PS(m10, m11, m12, m13);
+			_MM_TRANSPOSE4_PS(m20, m21, m22, m23);
+
+			rows[0] = m00; rows[1] = m10; rows[2] = m20;
+			rows[3] = m01; rows[4] = m11; rows[5] = m21;
+			rows[6] = m02; rows[7] = m12; rows[8] = m22;
+			rows[9] = m03; rows[10] = m13; rows[11] = m23;
+		}
+
+		void Transformations(const Transform* src, Matrix4* dst, usize count)
+		{
+			const __m128 bottom = _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f);
+
+			usize i = 0;
+
+			for (; i + 4 <= count; i += 4)
+			{
+				__m128 rows[12];
+				TransformationRows(src + i, rows);
+
+				for (usize j = 0; j < 4; j++)
+				{
+					float* matrix = dst[i + j].data;
+
+					_mm_storeu_ps(matrix + 0, rows[j * 3 + 0]);
+					_mm_storeu_ps(matrix + 4, rows[j * 3 + 1]);
+					_mm_storeu_ps(matrix + 8, rows[j * 3 + 2]);
+					_mm_storeu_ps(matrix + 12, bottom);
+				}
+			}
+
+			for (; i < count; i++)
+			{
+				dst[i] = Transformation(src[i]);
+			}
+		}
+
+		void Transformations(const Transform* src, Matrix3x4* dst, usize count)
+		{
+			usize i = 0;
+
+			for (; i + 4 <= count; i += 4)
+			{
+				__m128 rows[12];
+				TransformationRows(src + i, rows);
+
+				for (usize j = 0; j < 4; j++)
+				{
+					float* matrix = dst[i + j].data;
+
+					_mm_storeu_ps(matrix + 0, rows[j * 3 + 0]);
+					_mm_storeu_ps(matrix + 4, rows[j * 3 + 1]);
+					_mm_storeu_ps(matrix + 8, rows[j * 3 + 2]);
+				}
+			}
+
+			for (; i < count; i++)
+			{
+				dst[i] = Matrix3x4(Transformation(src[i]));
+			}
+		}
+	}
+}
@@ -230,6 +230,14 @@ namespace FM
 			return Transformation(t.translation, t.rotation, t.scale);
 		}
 
+		/// Writes the matrices of count transforms, with the same results as calling Transformation() for each.
+		/// Four transforms are converted at a time with SSE. The destination is written sequentially and never read,
+		/// so it can be a mapped upload buffer. It doesn't have to be aligned.
+		void Transformations(const Transform* src, Matrix4* dst, usize count);
+
+		/// Same as above, but only writes the top three rows of each matrix, the bottom row of an affine matrix is always 0, 0, 0, 1.
+		void Transformations(const Transform* src, Matrix3x4* dst, usize count);
+
 		// Projection
 
 		template <typename T>
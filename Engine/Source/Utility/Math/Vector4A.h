@@ -0,0 +1,161 @@
+// Copyright (c) 2020 Lauro Oyen, FmEngine contributors. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md for full terms. This notice is not to be removed.
+
+#pragma once
+
+#include "../CoreTypes.h"
+#include "Vector.h"
+
+#include <xmmintrin.h>
+#include <emmintrin.h>
+
+namespace FM
+{
+	/// 4 dimensional float vector stored in an SSE register.
+	/// Aligned counterpart of Vector4 for hot paths, the operations give the same results as those of Vector4.
+
+	struct alignas(16) Vector4A
+	{
+		__m128 v;
+
+		Vector4A()
+			: v(_mm_setzero_ps()) {}
+
+		explicit Vector4A(__m128 v)
+			: v(v) {}
+
+		explicit Vector4A(float all)
+			: v(_mm_set1_ps(all)) {}
+
+		Vector4A(float x, float y, float z, float w)
+			: v(_mm_setr_ps(x, y, z, w)) {}
+
+		Vector4A(const Vector4& other)
+			: v(_mm_loadu_ps(other.data)) {}
+
+		operator Vector4() const
+		{
+			Vector4 r;
+			_mm_storeu_ps(r.data, v);
+			return r;
+		}
+
+		float operator[] (usize i) const
+		{
+			alignas(16) float data[4];
+			_mm_store_ps(data, v);
+			return data[i];
+		}
+
+		float X() const { return _mm_cvtss_f32(v); }
+		float Y() const { return _mm_cvtss_f32(_mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1))); }
+		float Z() const { return _mm_cvtss_f32(_mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2))); }
+		float W() const { return _mm_cvtss_f32(_mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3))); }
+	};
+
+	// Operators
+
+	inline Vector4A operator- (const Vector4A& lhs)
+	{
+		return Vector4A(_mm_sub_ps(_mm_setzero_ps(), lhs.v));
+	}
+
+	// Arithmetic operators
+
+	inline Vector4A operator+ (const Vector4A& lhs, const Vector4A& rhs)
+	{
+		return Vector4A(_mm_add_ps(lhs.v, rhs.v));
+	}
+
+	inline Vector4A operator- (const Vector4A& lhs, const Vector4A& rhs)
+	{
+		return Vector4A(_mm_sub_ps(lhs.v, rhs.v));
+	}
+
+	inline Vector4A operator* (const Vector4A& lhs, float rhs)
+	{
+		return Vector4A(_mm_mul_ps(lhs.v, _mm_set1_ps(rhs)));
+	}
+
+	inline Vector4A operator/ (const Vector4A& lhs, float rhs)
+	{
+		return Vector4A(_mm_div_ps(lhs.v, _mm_set1_ps(rhs)));
+	}
+
+	// Assignment operators
+
+	inline Vector4A& operator+= (Vector4A& lhs, const Vector4A& rhs) {
+		return lhs = lhs + rhs;
+	}
+
+	inline Vector4A& operator-= (Vector4A& lhs, const Vector4A& rhs) {
+		return lhs = lhs - rhs;
+	}
+
+	inline Vector4A& operator*= (Vector4A& lhs, float rhs) {
+		return lhs = lhs * rhs;
+	}
+
+	inline Vector4A& operator/= (Vector4A& lhs, float rhs) {
+		return lhs = lhs / rhs;
+	}
+
+	// Relational operators
+
+	inline bool operator== (const Vector4A& lhs, const Vector4A& rhs)
+	{
+		return _mm_movemask_ps(_mm_cmpeq_ps(lhs.v, rhs.v)) == 0xF;
+	}
+
+	inline bool operator!= (const Vector4A& lhs, const Vector4A& rhs)
+	{
+		return !(lhs == rhs);
+	}
+
+	// Calculations
+
+	namespace Math
+	{
+		/// Sums the products in the order x, y, z, w like the generic Dot().
+		inline float Dot(const Vector4A& lhs, const Vector4A& rhs)
+		{
+			const __m128 p = _mm_mul_ps(lhs.v, rhs.v);
+
+			__m128 r = p;
+			r = _mm_add_ss(r, _mm_shuffle_ps(p, p, _MM_SHUFFLE(1, 1, 1, 1)));
+			r = _mm_add_ss(r, _mm_shuffle_ps(p, p, _MM_SHUFFLE(2, 2, 2, 2)));
+			r = _mm_add_ss(r, _mm_shuffle_ps(p, p, _MM_SHUFFLE(3, 3, 3, 3)));
+
+			return _mm_cvtss_f32(r);
+		}
+
+		/// Cross product of the xyz components, w is 0.
+		inline Vector4A Cross(const Vector4A& lhs, const Vector4A& rhs)
+		{
+			const __m128 l = _mm_shuffle_ps(lhs.v, lhs.v, _MM_SHUFFLE(3, 0, 2, 1));	// y z x
+			const __m128 r = _mm_shuffle_ps(rhs.v, rhs.v, _MM_SHUFFLE(3, 1, 0, 2));	// z x y
+			const __m128 a = _mm_shuffle_ps(lhs.v, lhs.v, _MM_SHUFFLE(3, 1, 0, 2));	// z x y
+			const __m128 b = _mm_shuffle_ps(rhs.v, rhs.v, _MM_SHUFFLE(3, 0, 2, 1));	// y z x
+
+			const __m128 cross = _mm_sub_ps(_mm_mul_ps(l, r), _mm_mul_ps(a, b));
+
+			// Clear w, which is 0 for finite inputs but may be NaN otherwise.
+			return Vector4A(_mm_and_ps(cross, _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0))));
+		}
+
+		inline float LengthSquared(const Vector4A& x)
+		{
+			return Dot(x, x);
+		}
+
+		inline float Length(const Vector4A& x)
+		{
+			return _mm_cvtss_f32(_mm_sqrt_ss(_mm_set_ss(LengthSquared(x))));
+		}
+
+		inline Vector4A Normalize(const Vector4A& x)
+		{
+			return x / Length(x);
+		}
+	}
+}
@@ -0,0 +1,540 @@
+// Copyright (c) 2020 Lauro Oyen, FmEngine contributors. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md for full terms. This notice is not to be removed.
+
+#pragma once
+
+#include "../CoreTypes.h"
+#include "Vector.h"
+#include "Matrix.h"
+#include "Quaternion.h"
+
+#include <xmmintrin.h>
+#include <emmintrin.h>
+
+namespace FM
+{
+	/// N floats that are processed in parallel, N is a multiple of 4 and every 4 lanes occupy an SSE register.
+	/// The building block of the structure-of-arrays types below, which process N vectors or quaternions at once.
+
+	template <uint N>
+	struct alignas(16) TFloatxN
+	{
+		static_assert(N > 0 && N % 4 == 0, "Lane count must be a multiple of 4.");
+
+		static constexpr uint Lanes = N;
+		static constexpr uint Registers = N / 4;
+
+		__m128 v[Registers];
+
+		TFloatxN()
+		{
+			for (uint i = 0; i < Registers; i++) v[i] = _mm_setzero_ps();
+		}
+
+		TFloatxN(float all)
+		{
+			for (uint i = 0; i < Registers; i++) v[i] = _mm_set1_ps(all);
+		}
+
+		/// Loads N floats, the source doesn't have to be aligned.
+		static TFloatxN Load(const float* src)
+		{
+			TFloatxN r;
+			for (uint i = 0; i < Registers; i++) r.v[i] = _mm_loadu_ps(src + i * 4);
+			return r;
+		}
+
+		/// Stores N floats, the destination doesn't have to be aligned.
+		void Store(float* dst) const
+		{
+			for (uint i = 0; i < Registers; i++) _mm_storeu_ps(dst + i * 4, v[i]);
+		}
+
+		float operator[] (usize i) const
+		{
+			alignas(16) float lanes[N];
+			for (uint r = 0; r < Registers; r++) _mm_store_ps(lanes + r * 4, v[r]);
+			return lanes[i];
+		}
+	};
+
+	// Operators
+
+	template <uint N>
+	inline TFloatxN<N> operator- (const TFloatxN<N>& lhs)
+	{
+		TFloatxN<N> r;
+		for (uint i = 0; i < N / 4; i++) r.v[i] = _mm_sub_ps(_mm_setzero_ps(), lhs.v[i]);
+		return r;
+	}
+
+	// Arithmetic operators
+
+	template <uint N>
+	inline TFloatxN<N> operator+ (const TFloatxN<N>& lhs, const TFloatxN<N>& rhs)
+	{
+		TFloatxN<N> r;
+		for (uint i = 0; i < N / 4; i++) r.v[i] = _mm_add_ps(lhs.v[i], rhs.v[i]);
+		return r;
+	}
+
+	template <uint N>
+	inline TFloatxN<N> operator- (const TFloatxN<N>& lhs, const TFloatxN<N>& rhs)
+	{
+		TFloatxN<N> r;
+		for (uint i = 0; i < N / 4; i++) r.v[i] = _mm_sub_ps(lhs.v[i], rhs.v[i]);
+		return r;
+	}
+
+	template <uint N>
+	inline TFloatxN<N> operator* (const TFloatxN<N>& lhs, const TFloatxN<N>& rhs)
+	{
+		TFloatxN<N> r;
+		for (uint i = 0; i < N / 4; i++) r.v[i] = _mm_mul_ps(lhs.v[i], rhs.v[i]);
+		return r;
+	}
+
+	template <uint N>
+	inline TFloatxN<N> operator/ (const TFloatxN<N>& lhs, const TFloatxN<N>& rhs)
+	{
+		TFloatxN<N> r;
+		for (uint i = 0; i < N / 4; i++) r.v[i] = _mm_div_ps(lhs.v[i], rhs.v[i]);
+		return r;
+	}
+
+	template <uint N>
+	inline TFloatxN<N> operator+ (const TFloatxN<N>& lhs, float rhs) {
+		return lhs + TFloatxN<N>(rhs);
+	}
+
+	template <uint N>
+	inline TFloatxN<N> operator- (const TFloatxN<N>& lhs, float rhs) {
+		return lhs - TFloatxN<N>(rhs);
+	}
+
+	template <uint N>
+	inline TFloatxN<N> operator* (const TFloatxN<N>& lhs, float rhs) {
+		return lhs * TFloatxN<N>(rhs);
+	}
+
+	template <uint N>
+	inline TFloatxN<N> operator/ (const TFloatxN<N>& lhs, float rhs) {
+		return lhs / TFloatxN<N>(rhs);
+	}
+
+	// Assignment operators
+
+	template <uint N>
+	inline TFloatxN<N>& operator+= (TFloatxN<N>& lhs, const TFloatxN<N>& rhs) {
+		return lhs = lhs + rhs;
+	}
+
+	template <uint N>
+	inline TFloatxN<N>& operator-= (TFloatxN<N>& lhs, const TFloatxN<N>& rhs) {
+		return lhs = lhs - rhs;
+	}
+
+	template <uint N>
+	inline TFloatxN<N>& operator*= (TFloatxN<N>& lhs, const TFloatxN<N>& rhs) {
+		return lhs = lhs * rhs;
+	}
+
+	template <uint N>
+	inline TFloatxN<N>& operator/= (TFloatxN<N>& lhs, const TFloatxN<N>& rhs) {
+		return lhs = lhs / rhs;
+	}
+
+	static_assert(sizeof(Vector3) == 3 * sizeof(float) && sizeof(Quaternion) == 4 * sizeof(float), "Vectors and quaternions are expected to be tightly packed.");
+
+	/// N 3 dimensional vectors in structure-of-arrays layout.
+
+	template <uint N>
+	struct TVector3xN
+	{
+		TFloatxN<N> x, y, z;
+
+		TVector3xN() = default;
+
+		TVector3xN(const TFloatxN<N>& x, const TFloatxN<N>& y, const TFloatxN<N>& z)
+			: x(x), y(y), z(z) {}
+
+		/// Sets all lanes to the same vector.
+		explicit TVector3xN(const Vector3& all)
+			: x(all.x), y(all.y), z(all.z) {}
+
+		/// Loads count vectors, at most N, from an array of vectors. Remaining lanes are zero.
+		static TVector3xN Load(const Vector3* src, usize count = N)
+		{
+			TVector3xN r;
+
+			for (uint i = 0; i < TFloatxN<N>::Registers; i++)
+			{
+				const usize first = i * 4;
+
+				if (first + 4 <= count)
+				{
+					// Four packed vectors are exactly three registers, shuffle them into x, y and z.
+					const float* p = &src[first].x;
+					const __m128 a = _mm_loadu_ps(p);		// x0 y0 z0 x1
+					const __m128 b = _mm_loadu_ps(p + 4);	// y1 z1 x2 y2
+					const __m128 c = _mm_loadu_ps(p + 8);	// z2 x3 y3 z3
+
+					const __m128 xbc = _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2));
+					const __m128 yab = _mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1));
+					const __m128 ybc = _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3));
+					const __m128 zab = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2));
+					const __m128 zc = _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0));
+
+					r.x.v[i] = _mm_shuffle_ps(a, xbc, _MM_SHUFFLE(2, 0, 3, 0));
+					r.y.v[i] = _mm_shuffle_ps(yab, ybc, _MM_SHUFFLE(2, 0, 2, 0));
+					r.z.v[i] = _mm_shuffle_ps(zab, zc, _MM_SHUFFLE(2, 0, 2, 0));
+				}
+				else if (first < count)
+				{
+					// The tail loads every vector on its own, reading past the last one could cross the end of the array.
+					__m128 rows[4];
+
+					for (usize j = 0; j < 4; j++)
+					{
+						rows[j] = first + j < count ? _mm_setr_ps(src[first + j].x, src[first + j].y, src[first + j].z, 0.0f) : _mm_setzero_ps();
+					}
+
+					_MM_TRANSPOSE4_PS(rows[0], rows[1], rows[2], rows[3]);
+
+					r.x.v[i] = rows[0];
+					r.y.v[i] = rows[1];
+					r.z.v[i] = rows[2];
+				}
+			}
+
+			return r;
+		}
+
+		/// Stores the first count vectors, at most N, to an array of vectors.
+		void Store(Vector3* dst, usize count = N) const
+		{
+			for (uint i = 0; i < TFloatxN<N>::Registers; i++)
+			{
+				const usize first = i * 4;
+
+				if (first + 4 <= count)
+				{
+					// Inverse of the shuffles in Load().
+					const __m128 x0y0 = _mm_shuffle_ps(x.v[i], y.v[i], _MM_SHUFFLE(0, 0, 0, 0));
+					const __m128 z0x1 = _mm_shuffle_ps(z.v[i], x.v[i], _MM_SHUFFLE(1, 1, 0, 0));
+					const __m128 y1z1 = _mm_shuffle_ps(y.v[i], z.v[i], _MM_SHUFFLE(1, 1, 1, 1));
+					const __m128 x2y2 = _mm_shuffle_ps(x.v[i], y.v[i], _MM_SHUFFLE(2, 2, 2, 2));
+					const __m128 z2x3 = _mm_shuffle_ps(z.v[i], x.v[i], _MM_SHUFFLE(3, 3, 2, 2));
+					const __m128 y3z3 = _mm_shuffle_ps(y.v[i], z.v[i], _MM_SHUFFLE(3, 3, 3, 3));
+
+					float* p = &dst[first].x;
+					_mm_storeu_ps(p, _mm_shuffle_ps(x0y0, z0x1, _MM_SHUFFLE(2, 0, 2, 0)));
+					_mm_storeu_ps(p + 4, _mm_shuffle_ps(y1z1, x2y2, _MM_SHUFFLE(2, 0, 2, 0)));
+					_mm_storeu_ps(p + 8, _mm_shuffle_ps(z2x3, y3z3, _MM_SHUFFLE(2, 0, 2, 0)));
+				}
+				else if (first < count)
+				{
+					__m128 rows[4] = { x.v[i], y.v[i], z.v[i], _mm_setzero_ps() };
+					_MM_TRANSPOSE4_PS(rows[0], rows[1], rows[2], rows[3]);
+
+					for (usize j = 0; first + j < count; j++)
+					{
+						alignas(16) float row[4];
+						_mm_store_ps(row, rows[j]);
+						dst[first + j] = Vector3(row[0], row[1], row[2]);
+					}
+				}
+			}
+		}
+	};
+
+	template <uint N>
+	inline TVector3xN<N> operator- (const TVector3xN<N>& lhs)
+	{
+		return TVector3xN<N>(-lhs.x, -lhs.y, -lhs.z);
+	}
+
+	template <uint N>
+	inline TVector3xN<N> operator+ (const TVector3xN<N>& lhs, const TVector3xN<N>& rhs)
+	{
+		return TVector3xN<N>(lhs.x + rhs.x, lhs.y + rhs.y, lhs.z + rhs.z);
+	}
+
+	template <uint N>
+	inline TVector3xN<N> operator- (const TVector3xN<N>& lhs, const TVector3xN<N>& rhs)
+	{
+		return TVector3xN<N>(lhs.x - rhs.x, lhs.y - rhs.y, lhs.z - rhs.z);
+	}
+
+	/// Scales every vector by the float in its lane.
+	template <uint N>
+	inline TVector3xN<N> operator* (const TVector3xN<N>& lhs, const TFloatxN<N>& rhs)
+	{
+		return TVector3xN<N>(lhs.x * rhs, lhs.y * rhs, lhs.z * rhs);
+	}
+
+	template <uint N>
+	inline TVector3xN<N> operator/ (const TVector3xN<N>& lhs, const TFloatxN<N>& rhs)
+	{
+		return TVector3xN<N>(lhs.x / rhs, lhs.y / rhs, lhs.z / rhs);
+	}
+
+	/// N quaternions in structure-of-arrays layout.
+
+	template <uint N>
+	struct TQuaternionxN
+	{
+		TFloatxN<N> x, y, z, w;
+
+		TQuaternionxN() = default;
+
+		TQuaternionxN(const TFloatxN<N>& x, const TFloatxN<N>& y, const TFloatxN<N>& z, const TFloatxN<N>& w)
+			: x(x), y(y), z(z), w(w) {}
+
+		/// Sets all lanes to the same quaternion.
+		explicit TQuaternionxN(const Quaternion& all)
+			: x(all.x), y(all.y), z(all.z), w(all.w) {}
+
+		/// Loads count quaternions, at most N, from an array of quaternions. Remaining lanes are the identity.
+		static TQuaternionxN Load(const Quaternion* src, usize count = N)
+		{
+			TQuaternionxN r;
+
+			const __m128 identity = _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f);
+
+			for (uint i = 0; i < TFloatxN<N>::Registers; i++)
+			{
+				const usize first = i * 4;
+
+				// Every quaternion is a register, transpose four of them into x, y, z and w.
+				__m128 rows[4];
+
+				for (usize j = 0; j < 4; j++)
+				{
+					rows[j] = first + j < count ? _mm_loadu_ps(&src[first + j].x) : identity;
+				}
+
+				_MM_TRANSPOSE4_PS(rows[0], rows[1], rows[2], rows[3]);
+
+				r.x.v[i] = rows[0];
+				r.y.v[i] = rows[1];
+				r.z.v[i] = rows[2];
+				r.w.v[i] = rows[3];
+			}
+
+			return r;
+		}
+
+		/// Stores the first count quaternions, at most N, to an array of quaternions.
+		void Store(Quaternion* dst, usize count = N) const
+		{
+			for (uint i = 0; i < TFloatxN<N>::Registers; i++)
+			{
+				const usize first = i * 4;
+
+				if (!(first < count)) break;
+
+				__m128 rows[4] = { x.v[i], y.v[i], z.v[i], w.v[i] };
+				_MM_TRANSPOSE4_PS(rows[0], rows[1], rows[2], rows[3]);
+
+				for (usize j = 0; j < 4 && first + j < count; j++)
+				{
+					_mm_storeu_ps(&dst[first + j].x, rows[j]);
+				}
+			}
+		}
+	};
+
+	/// Hamilton product of the quaternions in every lane, like the product of Quaternion.
+	template <uint N>
+	inline TQuaternionxN<N> operator* (const TQuaternionxN<N>& lhs, const TQuaternionxN<N>& rhs)
+	{
+		return TQuaternionxN<N>
+		(
+			lhs.w * rhs.w - lhs.x * rhs.x - lhs.y * rhs.y - lhs.z * rhs.z,
+			lhs.w * rhs.x + lhs.x * rhs.w + lhs.y * rhs.z - lhs.z * rhs.y,
+			lhs.w * rhs.y + lhs.y * rhs.w + lhs.z * rhs.x - lhs.x * rhs.z,
+			lhs.w * rhs.z + lhs.z * rhs.w + lhs.x * rhs.y - lhs.y * rhs.x
+		);
+	}
+
+	// Type aliases
+
+	using Floatx4 = TFloatxN<4>;
+	using Floatx8 = TFloatxN<8>;
+	using Floatx16 = TFloatxN<16>;
+
+	using Vector3x4 = TVector3xN<4>;
+	using Vector3x8 = TVector3xN<8>;
+	using Vector3x16 = TVector3xN<16>;
+
+	using Quaternionx4 = TQuaternionxN<4>;
+	using Quaternionx8 = TQuaternionxN<8>;
+	using Quaternionx16 = TQuaternionxN<16>;
+
+	// Calculations
+
+	namespace Math
+	{
+		template <uint N>
+		inline TFloatxN<N> Sqrt(const TFloatxN<N>& x)
+		{
+			TFloatxN<N> r;
+			for (uint i = 0; i < N / 4; i++) r.v[i] = _mm_sqrt_ps(x.v[i]);
+			return r;
+		}
+
+		template <uint N>
+		inline TFloatxN<N> Min(const TFloatxN<N>& lhs, const TFloatxN<N>& rhs)
+		{
+			TFloatxN<N> r;
+			for (uint i = 0; i < N / 4; i++) r.v[i] = _mm_min_ps(lhs.v[i], rhs.v[i]);
+			return r;
+		}
+
+		template <uint N>
+		inline TFloatxN<N> Max(const TFloatxN<N>& lhs, const TFloatxN<N>& rhs)
+		{
+			TFloatxN<N> r;
+			for (uint i = 0; i < N / 4; i++) r.v[i] = _mm_max_ps(lhs.v[i], rhs.v[i]);
+			return r;
+		}
+
+		template <uint N>
+		inline TFloatxN<N> Dot(const TVector3xN<N>& lhs, const TVector3xN<N>& rhs)
+		{
+			return lhs.x * rhs.x + lhs.y * rhs.y + lhs.z * rhs.z;
+		}
+
+		template <uint N>
+		inline TVector3xN<N> Cross(const TVector3xN<N>& lhs, const TVector3xN<N>& rhs)
+		{
+			return TVector3xN<N>
+			(
+				lhs.y * rhs.z - lhs.z * rhs.y,
+				lhs.z * rhs.x - lhs.x * rhs.z,
+				lhs.x * rhs.y - lhs.y * rhs.x
+			);
+		}
+
+		template <uint N>
+		inline TFloatxN<N> LengthSquared(const TVector3xN<N>& x)
+		{
+			return Dot(x, x);
+		}
+
+		template <uint N>
+		inline TFloatxN<N> Length(const TVector3xN<N>& x)
+		{
+			return Sqrt(LengthSquared(x));
+		}
+
+		template <uint N>
+		inline TVector3xN<N> Normalize(const TVector3xN<N>& x)
+		{
+			return x / Length(x);
+		}
+
+		template <uint N>
+		inline TFloatxN<N> Dot(const TQuaternionxN<N>& lhs, const TQuaternionxN<N>& rhs)
+		{
+			return lhs.x * rhs.x + lhs.y * rhs.y + lhs.z * rhs.z + lhs.w * rhs.w;
+		}
+
+		template <uint N>
+		inline TQuaternionxN<N> Normalize(const TQuaternionxN<N>& q)
+		{
+			const TFloatxN<N> length = Sqrt(Dot(q, q));
+			return TQuaternionxN<N>(q.x / length, q.y / length, q.z / length, q.w / length);
+		}
+
+		/// Rotates the vector in every lane by the unit quaternion in the same lane.
+		template <uint N>
+		inline TVector3xN<N> Rotate(const TQuaternionxN<N>& q, const TVector3xN<N>& v)
+		{
+			// v' = v + w * t + q.xyz x t, where t = 2 * (q.xyz x v).
+			const TVector3xN<N> u(q.x, q.y, q.z);
+			const TVector3xN<N> t = Cross(u, v) * TFloatxN<N>(2.0f);
+
+			return v + t * q.w + Cross(u, t);
+		}
+
+		/// Transforms the point in every lane by the same matrix, the points have an implicit w of 1.
+		template <uint N>
+		inline TVector3xN<N> TransformPoint(const Matrix4& m, const TVector3xN<N>& p)
+		{
+			return TVector3xN<N>
+			(
+				p.x * m(0, 0) + p.y * m(0, 1) + p.z * m(0, 2) + m(0, 3),
+				p.x * m(1, 0) + p.y * m(1, 1) + p.z * m(1, 2) + m(1, 3),
+				p.x * m(2, 0) + p.y * m(2, 1) + p.z * m(2, 2) + m(2, 3)
+			);
+		}
+
+		/// Transforms the direction in every lane by the same matrix, ignoring the translation.
+		template <uint N>
+		inline TVector3xN<N> TransformVector(const Matrix4& m, const TVector3xN<N>& v)
+		{
+			return TVector3xN<N>
+			(
+				v.x * m(0, 0) + v.y * m(0, 1) + v.z * m(0, 2),
+				v.x * m(1, 0) + v.y * m(1, 1) + v.z * m(1, 2),
+				v.x * m(2, 0) + v.y * m(2, 1) + v.z * m(2, 2)
+			);
+		}
+
+		// Batch operations on arrays of vectors, processed 8 lanes at a time.
+		// The source and destination may be the same array.
+
+		/// Transforms count points by the same matrix.
+		inline void TransformPoints(const Matrix4& m, const Vector3* src, Vector3* dst, usize count)
+		{
+			for (usize i = 0; i < count; i += 8)
+			{
+				const usize n = count - i < 8 ? count - i : 8;
+				TransformPoint(m, Vector3x8::Load(src + i, n)).Store(dst + i, n);
+			}
+		}
+
+		/// Rotates count vectors, each by the unit quaternion at the same index.
+		inline void RotateVectors(const Quaternion* rotations, const Vector3* src, Vector3* dst, usize count)
+		{
+			for (usize i = 0; i < count; i += 8)
+			{
+				const usize n = count - i < 8 ? count - i : 8;
+				Rotate(Quaternionx8::Load(rotations + i, n), Vector3x8::Load(src + i, n)).Store(dst + i, n);
+			}
+		}
+
+		/// Normalizes count vectors, which must not have a length of zero.
+		inline void NormalizeVectors(const Vector3* src, Vector3* dst, usize count)
+		{
+			for (usize i = 0; i < count; i += 8)
+			{
+				const usize n = count - i < 8 ? count - i : 8;
+				Normalize(Vector3x8::Load(src + i, n)).Store(dst + i, n);
+			}
+		}
+
+		/// Writes the dot product of the vectors at every index.
+		inline void DotVectors(const Vector3* lhs, const Vector3* rhs, float* dst, usize count)
+		{
+			for (usize i = 0; i < count; i += 8)
+			{
+				const usize n = count - i < 8 ? count - i : 8;
+				const Floatx8 dot = Dot(Vector3x8::Load(lhs + i, n), Vector3x8::Load(rhs + i, n));
+
+				if (n == 8)
+				{
+					dot.Store(dst + i);
+					continue;
+				}
+
+				alignas(16) float lanes[8];
+				dot.Store(lanes);
+
+				for (usize j = 0; j < n; j++) dst[i + j] = lanes[j];
+			}
+		}
+	}
+}
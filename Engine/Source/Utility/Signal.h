@@ -0,0 +1,59 @@
+// Copyright (c) 2020 Lauro Oyen, FmEngine contributors. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md for full terms. This notice is not to be removed.
+
+#pragma once
+
+#include "CoreTypes.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace FM
+{
+	/// List of callbacks that are called in the order they were connected when the signal is emitted.
+	/// A callback is a plain function that receives the arguments of the signal followed by the user pointer it was connected with.
+
+	template <typename... Args>
+	class TSignal
+	{
+	public:
+
+		typedef void(*Callback)(Args... args, void* user);
+
+		void Connect(Callback callback, void* user = nullptr)
+		{
+			mSlots.push_back({ callback, user });
+		}
+
+		/// Disconnects the callback that was connected with the same user pointer.
+		void Disconnect(Callback callback, void* user = nullptr)
+		{
+			mSlots.erase(std::remove_if(mSlots.begin(), mSlots.end(), [callback, user](const Slot& slot) {
+				return slot.callback == callback && slot.user == user;
+			}), mSlots.end());
+		}
+
+		/// Calls all connected callbacks, callbacks must not connect or disconnect from this signal.
+		void Emit(Args... args) const
+		{
+			for (const Slot& slot : mSlots)
+			{
+				slot.callback(args..., slot.user);
+			}
+		}
+
+		bool Empty() const {
+			return mSlots.empty();
+		}
+
+	private:
+
+		struct Slot
+		{
+			Callback callback;
+			void* user;
+		};
+
+		std::vector<Slot> mSlots;
+	};
+}
@@ -0,0 +1,369 @@
+// Copyright (c) 2020 Lauro Oyen, FmEngine contributors. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md for full terms. This notice is not to be removed.
+
+#include "JobSystem.h"
+
+#include <chrono>
+
+namespace FM
+{
+	JobSystem GJobSystem;
+
+	namespace
+	{
+		constexpr usize InvalidThread = ~usize(0);
+
+		/// Index of the current thread in the job system.
+		thread_local usize tThread = InvalidThread;
+
+		struct Range
+		{
+			RangeCallback callback;
+			void* user;
+			usize grainSize;
+			JobCounter* counter;
+		};
+
+		/// Splits off the upper half as a new job until the range is small enough to process directly.
+		void RunRange(JobSystem& system, const Range* range, usize begin, usize end)
+		{
+			while (end - begin > range->grainSize)
+			{
+				const usize grains = (end - begin + range->grainSize - 1) / range->grainSize;
+				const usize mid = begin + (grains / 2) * range->grainSize;
+
+				system.Run([&system, range, mid, end]() { RunRange(system, range, mid, end); }, range->counter);
+
+				end = mid;
+			}
+
+			range->callback(begin, end, range->user);
+		}
+
+		uint32 XorShift(uint32& state)
+		{
+			state ^= state << 13;
+			state ^= state >> 17;
+			state ^= state << 5;
+			return state;
+		}
+	}
+
+	// Queue
+
+	bool JobSystem::Queue::Push(Job* job)
+	{
+		const int64 bottom = mBottom.load(std::memory_order_relaxed);
+		const int64 top = mTop.load(std::memory_order_acquire);
+
+		if (bottom - top >= static_cast<int64>(QueueCapacity)) return false;
+
+		mJobs[bottom & Mask].store(job, std::memory_order_release);
+		std::atomic_thread_fence(std::memory_order_release);
+		mBottom.store(bottom + 1, std::memory_order_relaxed);
+
+		return true;
+	}
+
+	JobSystem::Job* JobSystem::Queue::Pop()
+	{
+		const int64 bottom = mBottom.load(std::memory_order_relaxed) - 1;
+		mBottom.store(bottom, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64 top = mTop.load(std::memory_order_relaxed);
+
+		if (top > bottom)
+		{
+			// Empty.
+			mBottom.store(bottom + 1, std::memory_order_relaxed);
+			return nullptr;
+		}
+
+		Job* job = mJobs[bottom & Mask].load(std::memory_order_relaxed);
+
+		if (top == bottom)
+		{
+			// Last job, race against thieves.
+			if (!mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			{
+				job = nullptr;
+			}
+
+			mBottom.store(bottom + 1, std::memory_order_relaxed);
+		}
+
+		return job;
+	}
+
+	JobSystem::Job* JobSystem::Queue::Steal()
+	{
+		int64 top = mTop.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		const int64 bottom = mBottom.load(std::memory_order_acquire);
+
+		if (top >= bottom) return nullptr;
+
+		Job* job = mJobs[top & Mask].load(std::memory_order_acquire);
+
+		if (!mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+		{
+			return nullptr;
+		}
+
+		return job;
+	}
+
+	// JobSystem
+
+	JobSystem::~JobSystem()
+	{
+		Shutdown();
+	}
+
+	void JobSystem::Init(usize workerCount)
+	{
+		if (!mThreads.empty()) return;
+
+		if (workerCount == 0)
+		{
+			const usize hardware = std::thread::hardware_concurrency();
+			workerCount = hardware > 1 ? hardware - 1 : 1;
+		}
+
+		mQuit = false;
+
+		for (usize i = 0; i < workerCount + 1; i++)
+		{
+			mThreads.push_back(std::make_unique<ThreadData>());
+			mThreads.back()->random = static_cast<uint32>(i + 1) * 0x9E3779B9u;
+		}
+
+		tThread = 0;
+
+		for (usize i = 1; i < mThreads.size(); i++)
+		{
+			mWorkers.emplace_back(&JobSystem::WorkerMain, this, i);
+		}
+	}
+
+	void JobSystem::Shutdown()
+	{
+		mQuit = true;
+
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mWake.notify_all();
+		}
+
+		for (std::thread& worker : mWorkers)
+		{
+			worker.join();
+		}
+
+		mWorkers.clear();
+		mThreads.clear();
+
+		tThread = InvalidThread;
+	}
+
+	void JobSystem::Wait(const JobCounter& counter)
+	{
+		const usize thread = tThread;
+
+		while (!counter.Done())
+		{
+			if (thread == InvalidThread || !RunOne(thread))
+			{
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	void JobSystem::Submit(JobCallback callback, const void* data, usize size, JobCounter* counter, const JobCounter* dependency)
+	{
+		const usize thread = tThread;
+
+		if (thread == InvalidThread || mThreads.empty())
+		{
+			if (dependency) Wait(*dependency);
+			callback(const_cast<void*>(data));
+			return;
+		}
+
+		ThreadData& self = *mThreads[thread];
+
+		Job* job = Allocate(self);
+
+		if (!job)
+		{
+			if (counter) counter->mValue.fetch_add(1, std::memory_order_relaxed);
+
+			Job local;
+			local.callback = callback;
+			local.counter = counter;
+			Memory::Memcpy(local.data, data, size);
+
+			if (dependency) Wait(*dependency);
+			Execute(&local);
+			return;
+		}
+
+		job->callback = callback;
+		job->counter = counter;
+		job->dependency = dependency;
+		Memory::Memcpy(job->data, data, size);
+
+		if (counter)
+		{
+			counter->mValue.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		if (!self.queue.Push(job))
+		{
+			if (dependency) Wait(*dependency);
+			Execute(job);
+			return;
+		}
+
+		if (mSleeping.load(std::memory_order_relaxed) > 0)
+		{
+			mWake.notify_one();
+		}
+	}
+
+	void JobSystem::Split(usize count, usize grainSize, RangeCallback callback, void* user)
+	{
+		if (count == 0) return;
+
+		if (grainSize == 0) grainSize = BatchSize(count);
+
+		if (tThread == InvalidThread || mThreads.size() < 2 || count <= grainSize)
+		{
+			callback(0, count, user);
+			return;
+		}
+
+		JobCounter counter;
+		const Range range = { callback, user, grainSize, &counter };
+
+		RunRange(*this, &range, 0, count);
+
+		Wait(counter);
+	}
+
+	bool JobSystem::RunOne(usize thread)
+	{
+		ThreadData& self = *mThreads[thread];
+
+		auto blocked = [](const Job* job) { return job->dependency && !job->dependency->Done(); };
+
+		Job* job = self.queue.Pop();
+
+		if (!job)
+		{
+			const usize victim = XorShift(self.random) % mThreads.size();
+			if (victim != thread) job = mThreads[victim]->queue.Steal();
+		}
+
+		if (!job) return false;
+
+		if (blocked(job))
+		{
+			// Put the job back and try the oldest job of the own queue instead, it might be the dependency.
+			if (!self.queue.Push(job))
+			{
+				Wait(*job->dependency);
+				Execute(job);
+				return true;
+			}
+
+			job = self.queue.Steal();
+
+			if (!job) return false;
+
+			if (blocked(job))
+			{
+				if (!self.queue.Push(job))
+				{
+					Wait(*job->dependency);
+					Execute(job);
+					return true;
+				}
+
+				return false;
+			}
+		}
+
+		Execute(job);
+
+		return true;
+	}
+
+	JobSystem::Job* JobSystem::Allocate(ThreadData& self)
+	{
+		for (usize i = 0; i < QueueCapacity; i++)
+		{
+			Job* job = &self.jobs[self.allocated++ % QueueCapacity];
+
+			if (!job->used.load(std::memory_order_acquire))
+			{
+				job->used.store(true, std::memory_order_relaxed);
+				return job;
+			}
+		}
+
+		return nullptr;
+	}
+
+	void JobSystem::Execute(Job* job)
+	{
+		// Run from a copy and release the slot, so nested jobs can reuse it while this one is still running.
+		const JobCallback callback = job->callback;
+		JobCounter* counter = job->counter;
+
+		uint8 data[JobDataSize];
+		Memory::Memcpy(data, job->data, JobDataSize);
+
+		job->used.store(false, std::memory_order_release);
+
+		callback(data);
+
+		if (counter)
+		{
+			counter->mValue.fetch_sub(1, std::memory_order_release);
+		}
+	}
+
+	void JobSystem::WorkerMain(usize thread)
+	{
+		tThread = thread;
+
+		usize idle = 0;
+
+		while (!mQuit.load(std::memory_order_relaxed))
+		{
+			if (RunOne(thread))
+			{
+				idle = 0;
+			}
+			else if (++idle < 64)
+			{
+				std::this_thread::yield();
+			}
+			else
+			{
+				// Sleep until a job is submitted, the timeout guards against a missed notification.
+				mSleeping.fetch_add(1, std::memory_order_relaxed);
+
+				{
+					std::unique_lock<std::mutex> lock(mMutex);
+					mWake.wait_for(lock, std::chrono::milliseconds(1));
+				}
+
+				mSleeping.fetch_sub(1, std::memory_order_relaxed);
+
+				idle = 0;
+			}
+		}
+	}
+}
@@ -0,0 +1,174 @@
+// Copyright (c) 2020 Lauro Oyen, FmEngine contributors. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md for full terms. This notice is not to be removed.
+
+#pragma once
+
+#include "../CoreTypes.h"
+#include "../Memory.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace FM
+{
+	typedef void(*JobCallback)(void* data);
+	typedef void(*RangeCallback)(usize begin, usize end, void* user);
+
+	/// Counts the number of unfinished jobs that were started with it.
+	/// Wait on a counter to synchronize with those jobs, or pass it as the dependency of another job.
+
+	class JobCounter
+	{
+	public:
+
+		/// Checks if all jobs associated with this counter have finished.
+		bool Done() const {
+			return mValue.load(std::memory_order_acquire) == 0;
+		}
+
+	private:
+
+		friend class JobSystem;
+
+		std::atomic<usize> mValue{ 0 };
+	};
+
+	/// Work-stealing job scheduler shared by all engine systems.
+	/// Every thread owns a Chase-Lev deque: it pushes and pops jobs at the bottom, idle threads steal from the top.
+	/// The thread that calls Init() becomes thread 0 and takes part in the work while it waits on a counter.
+	/// Jobs can only be started from threads of the job system, other threads run them inline.
+
+	class JobSystem
+	{
+	public:
+
+		static constexpr usize JobDataSize = 32;	///< Maximum size in bytes of the function object of a job.
+		static constexpr usize QueueCapacity = 4096;	///< Maximum number of queued jobs per thread, more jobs run inline.
+
+		JobSystem() = default;
+		~JobSystem();
+
+		JobSystem(const JobSystem&) = delete;
+		JobSystem& operator=(const JobSystem&) = delete;
+
+		/// Starts the worker threads.
+		/// By default one worker is started for every hardware thread except the calling one.
+		void Init(usize workerCount = 0);
+
+		/// Stops and joins all worker threads.
+		void Shutdown();
+
+		/// Returns the number of threads that execute jobs, including the thread that called Init().
+		usize ThreadCount() const {
+			return mThreads.empty() ? 1 : mThreads.size();
+		}
+
+		/// Starts a job that calls func().
+		/// The function object is copied into the job, so it must be small and trivially copyable, like a lambda capturing pointers.
+		/// The counter is incremented until the job has finished. The job doesn't start before the dependency is done.
+		template <typename Func>
+		void Run(const Func& func, JobCounter* counter = nullptr, const JobCounter* dependency = nullptr)
+		{
+			static_assert(sizeof(Func) <= JobDataSize, "Job function object is too large.");
+			static_assert(std::is_trivially_copyable_v<Func> && std::is_trivially_destructible_v<Func>, "Job function object must be trivially copyable.");
+
+			Submit([](void* data) { (*static_cast<Func*>(data))(); }, &func, sizeof(Func), counter, dependency);
+		}
+
+		/// Blocks until the counter is done, executing other jobs in the meantime.
+		void Wait(const JobCounter& counter);
+
+		/// Returns a minimum batch size for splitting count elements into a few batches per thread.
+		/// The size is a multiple of granularity, with the default of 64 elements no two batches share a cache line
+		/// of an array that starts on a cache line boundary, regardless of the element size.
+		usize BatchSize(usize count, usize granularity = 64) const
+		{
+			const usize batches = ThreadCount() * 8;
+			const usize size = (count + batches - 1) / batches;
+			return ((size + granularity - 1) / granularity) * granularity;
+		}
+
+		/// Calls func(begin, end) for batches that together cover [0, count) and returns when all of them are done.
+		/// The range is split in halves on demand, idle threads steal the upper halves, so the batch size adapts to the load.
+		/// Batches have at least grainSize elements and their bounds are multiples of grainSize, 0 picks BatchSize(count).
+		template <typename Func>
+		void ParallelFor(usize count, usize grainSize, const Func& func)
+		{
+			Split(count, grainSize, [](usize begin, usize end, void* user) { (*static_cast<const Func*>(user))(begin, end); }, const_cast<Func*>(&func));
+		}
+
+	private:
+
+		struct alignas(64) Job
+		{
+			JobCallback callback;
+			JobCounter* counter;
+			const JobCounter* dependency;
+			std::atomic<bool> used{ false };	///< Set from submission until a thread starts executing the job.
+			uint8 data[JobDataSize];
+		};
+
+		/// Chase-Lev work-stealing deque of a single thread.
+		class Queue
+		{
+		public:
+
+			/// Pushes a job at the bottom, only called by the owning thread. Returns false when full.
+			bool Push(Job* job);
+
+			/// Pops a job from the bottom, only called by the owning thread.
+			Job* Pop();
+
+			/// Steals a job from the top, called by any thread.
+			Job* Steal();
+
+		private:
+
+			static constexpr int64 Mask = QueueCapacity - 1;
+
+			alignas(64) std::atomic<int64> mTop{ 0 };
+			alignas(64) std::atomic<int64> mBottom{ 0 };
+			std::atomic<Job*> mJobs[QueueCapacity];
+		};
+
+		struct ThreadData
+		{
+			Queue queue;
+			Job jobs[QueueCapacity];	///< Ring of job storage, slots are skipped while still in use.
+			usize allocated = 0;
+			uint32 random = 0;			///< State of the random generator that picks a thread to steal from.
+		};
+
+		void Submit(JobCallback callback, const void* data, usize size, JobCounter* counter, const JobCounter* dependency);
+
+		void Split(usize count, usize grainSize, RangeCallback callback, void* user);
+
+		/// Returns a free job slot of the thread, or nullptr if all of them are in use.
+		Job* Allocate(ThreadData& self);
+
+		/// Executes a single job from the own queue or stolen from another thread, returns false if none was found.
+		bool RunOne(usize thread);
+
+		void Execute(Job* job);
+
+		void WorkerMain(usize thread);
+
+	private:
+
+		std::vector<std::unique_ptr<ThreadData>> mThreads;
+		std::vector<std::thread> mWorkers;
+
+		std::mutex mMutex;
+		std::condition_variable mWake;
+		std::atomic<usize> mSleeping{ 0 };
+		std::atomic<bool> mQuit{ false };
+	};
+
+	/// The global JobSystem object.
+	extern JobSystem GJobSystem;
+}
@@ -0,0 +1,265 @@
+// Copyright (c) 2020 Lauro Oyen, FmEngine contributors. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md for full terms. This notice is not to be removed.
+
+#include "ArchetypeWorld.h"
+
+#include <algorithm>
+#include <new>
+
+namespace FM
+{
+	namespace
+	{
+		usize AlignUp(usize value, usize alignment)
+		{
+			return (value + alignment - 1) & ~(alignment - 1);
+		}
+
+		/// Computes the column offsets for the given capacity and returns the number of bytes used.
+		usize Layout(const std::vector<const ComponentInfo*>& infos, usize capacity, std::vector<usize>& offsets)
+		{
+			usize offset = sizeof(Entity) * capacity;
+
+			offsets.resize(infos.size());
+
+			for (usize i = 0; i < infos.size(); i++)
+			{
+				offset = AlignUp(offset, infos[i]->alignment);
+				offsets[i] = offset;
+				offset += infos[i]->size * capacity;
+			}
+
+			return offset;
+		}
+	}
+
+	int ArchetypeWorld::Archetype::Find(ComponentID id) const
+	{
+		auto it = std::lower_bound(signature.begin(), signature.end(), id);
+		return (it != signature.end() && *it == id) ? static_cast<int>(it - signature.begin()) : -1;
+	}
+
+	ArchetypeWorld::ArchetypeWorld()
+	{
+		mRoot = FindOrCreate({});
+	}
+
+	ArchetypeWorld::~ArchetypeWorld()
+	{
+		for (const auto& archetype : mArchetypes)
+		{
+			for (usize row = 0; row < archetype->size; row++)
+			{
+				for (usize column = 0; column < archetype->infos.size(); column++)
+				{
+					archetype->infos[column]->destroy(archetype->Element(row, column));
+				}
+			}
+
+			for (uint8* chunk : archetype->chunks)
+			{
+				::operator delete(chunk, std::align_val_t(ChunkAlignment));
+			}
+		}
+	}
+
+	Entity ArchetypeWorld::Create()
+	{
+		Entity entity;
+
+		if (!mFreeList.empty())
+		{
+			entity = mEntities[mFreeList.back()];
+			mFreeList.pop_back();
+		}
+		else
+		{
+			entity = MakeEntity(static_cast<uint32>(mEntities.size()), 0);
+			mEntities.push_back(entity);
+			mRecords.push_back({ nullptr, 0 });
+		}
+
+		mRecords[EntityIndex(entity)] = { mRoot, Allocate(*mRoot, entity) };
+
+		return entity;
+	}
+
+	void ArchetypeWorld::Destroy(Entity entity)
+	{
+		FM_ASSERT(Valid(entity));
+
+		const uint32 index = EntityIndex(entity);
+		Record& record = mRecords[index];
+
+		Free(*record.archetype, record.row);
+
+		record = { nullptr, 0 };
+		mEntities[index] = MakeEntity(index, EntityVersion(entity) + 1);
+		mFreeList.push_back(index);
+	}
+
+	bool ArchetypeWorld::Valid(Entity entity) const
+	{
+		const uint32 index = EntityIndex(entity);
+		return index < mEntities.size() && mEntities[index] == entity;
+	}
+
+	bool ArchetypeWorld::Match(const Archetype& archetype, const ComponentID* ids, usize* columns, usize count)
+	{
+		for (usize i = 0; i < count; i++)
+		{
+			const int column = archetype.Find(ids[i]);
+			if (column < 0) return false;
+			columns[i] = column;
+		}
+
+		return true;
+	}
+
+	ArchetypeWorld::Archetype* ArchetypeWorld::FindOrCreate(const std::vector<const ComponentInfo*>& infos)
+	{
+		std::vector<ComponentID> signature(infos.size());
+
+		for (usize i = 0; i < infos.size(); i++)
+		{
+			signature[i] = infos[i]->id;
+		}
+
+		auto it = mLookup.find(signature);
+		if (it != mLookup.end()) return it->second;
+
+		auto archetype = std::make_unique<Archetype>();
+		archetype->signature = signature;
+		archetype->infos = infos;
+
+		// Estimate the capacity from the size of a row and shrink it until the padding between the columns fits as well.
+
+		usize rowSize = sizeof(Entity);
+		for (const ComponentInfo* info : infos) rowSize += info->size;
+
+		archetype->capacity = ChunkSize / rowSize;
+
+		while (archetype->capacity > 1 && Layout(infos, archetype->capacity, archetype->offsets) > ChunkSize)
+		{
+			archetype->capacity--;
+		}
+
+		Layout(infos, archetype->capacity, archetype->offsets);
+
+		FM_ASSERT(archetype->capacity > 0);
+
+		Archetype* result = archetype.get();
+
+		mArchetypes.push_back(std::move(archetype));
+		mLookup[signature] = result;
+
+		return result;
+	}
+
+	ArchetypeWorld::Archetype* ArchetypeWorld::AddEdge(Archetype& archetype, const ComponentInfo& info)
+	{
+		auto it = archetype.addEdges.find(info.id);
+		if (it != archetype.addEdges.end()) return it->second;
+
+		std::vector<const ComponentInfo*> infos = archetype.infos;
+		infos.insert(std::lower_bound(infos.begin(), infos.end(), &info, [](const ComponentInfo* lhs, const ComponentInfo* rhs) { return lhs->id < rhs->id; }), &info);
+
+		Archetype* target = FindOrCreate(infos);
+
+		archetype.addEdges[info.id] = target;
+		target->removeEdges[info.id] = &archetype;
+
+		return target;
+	}
+
+	ArchetypeWorld::Archetype* ArchetypeWorld::RemoveEdge(Archetype& archetype, ComponentID id)
+	{
+		auto it = archetype.removeEdges.find(id);
+		if (it != archetype.removeEdges.end()) return it->second;
+
+		std::vector<const ComponentInfo*> infos = archetype.infos;
+		infos.erase(infos.begin() + archetype.Find(id));
+
+		Archetype* target = FindOrCreate(infos);
+
+		archetype.removeEdges[id] = target;
+		target->addEdges[id] = &archetype;
+
+		return target;
+	}
+
+	usize ArchetypeWorld::Allocate(Archetype& archetype, Entity entity)
+	{
+		const usize row = archetype.size++;
+
+		if (row / archetype.capacity == archetype.chunks.size())
+		{
+			archetype.chunks.push_back(static_cast<uint8*>(::operator new(ChunkSize, std::align_val_t(ChunkAlignment))));
+		}
+
+		archetype.Entities(row / archetype.capacity)[row % archetype.capacity] = entity;
+
+		return row;
+	}
+
+	void ArchetypeWorld::Free(Archetype& archetype, usize row)
+	{
+		const usize last = archetype.size - 1;
+
+		for (usize column = 0; column < archetype.infos.size(); column++)
+		{
+			const ComponentInfo* info = archetype.infos[column];
+
+			info->destroy(archetype.Element(row, column));
+
+			if (row != last)
+			{
+				info->move(archetype.Element(row, column), archetype.Element(last, column));
+				info->destroy(archetype.Element(last, column));
+			}
+		}
+
+		if (row != last)
+		{
+			const Entity moved = archetype.Entities(last / archetype.capacity)[last % archetype.capacity];
+
+			archetype.Entities(row / archetype.capacity)[row % archetype.capacity] = moved;
+			mRecords[EntityIndex(moved)].row = row;
+		}
+
+		archetype.size--;
+
+		if (archetype.size % archetype.capacity == 0 && archetype.size / archetype.capacity < archetype.chunks.size())
+		{
+			::operator delete(archetype.chunks.back(), std::align_val_t(ChunkAlignment));
+			archetype.chunks.pop_back();
+		}
+	}
+
+	void ArchetypeWorld::Move(Entity entity, Archetype* to)
+	{
+		Record& record = mRecords[EntityIndex(entity)];
+		Archetype* from = record.archetype;
+
+		const usize row = Allocate(*to, entity);
+
+		for (usize column = 0; column < to->infos.size(); column++)
+		{
+			const int source = from->Find(to->signature[column]);
+
+			if (source >= 0)
+			{
+				to->infos[column]->move(to->Element(row, column), from->Element(record.row, source));
+			}
+			else
+			{
+				to->infos[column]->construct(to->Element(row, column));
+			}
+		}
+
+		// Destroys the moved-from components of the old row.
+		Free(*from, record.row);
+
+		record = { to, row };
+	}
+}
@@ -0,0 +1,224 @@
+// Copyright (c) 2020 Lauro Oyen, FmEngine contributors. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md for full terms. This notice is not to be removed.
+
+#pragma once
+
+#include "../Utility/CoreTypes.h"
+#include "../Utility/Assert.h"
+
+#include "Entity.h"
+#include "ComponentType.h"
+
+#include <vector>
+#include <array>
+#include <map>
+#include <unordered_map>
+#include <memory>
+#include <utility>
+
+namespace FM
+{
+	/// Alternative storage backend to World.
+	/// Entities with the same set of components share an archetype, which stores them in fixed size chunks.
+	/// Each chunk holds the entities followed by one tightly packed array (column) per component.
+	/// Iterating a query streams over the matching chunks without any per-entity membership tests,
+	/// at the cost of moving all components of an entity whenever a component is assigned or removed.
+	/// Offers the same entity and component interface as World, so either can be used for a scene.
+
+	class ArchetypeWorld
+	{
+	public:
+
+		static constexpr usize ChunkSize = 16 * 1024;	///< Size of a chunk in bytes.
+		static constexpr usize ChunkAlignment = 64;		///< Alignment of a chunk, components can't be aligned to more than this.
+
+		struct Archetype
+		{
+			std::vector<ComponentID> signature;			///< Sorted identifiers of the components.
+			std::vector<const ComponentInfo*> infos;	///< Component descriptions, parallel to signature.
+			std::vector<usize> offsets;					///< Byte offset of each column in a chunk, parallel to signature.
+
+			usize capacity = 0;							///< Number of entities per chunk.
+			usize size = 0;								///< Number of entities in this archetype.
+
+			std::vector<uint8*> chunks;
+
+			std::unordered_map<ComponentID, Archetype*> addEdges;		///< Archetype reached by assigning a component.
+			std::unordered_map<ComponentID, Archetype*> removeEdges;	///< Archetype reached by removing a component.
+
+			/// Returns the column of the component, or -1 if this archetype doesn't have it.
+			int Find(ComponentID id) const;
+
+			/// Returns the number of entities in a chunk.
+			usize Count(usize chunk) const {
+				return chunk + 1 < chunks.size() ? capacity : size - chunk * capacity;
+			}
+
+			Entity* Entities(usize chunk) const {
+				return reinterpret_cast<Entity*>(chunks[chunk]);
+			}
+
+			void* Column(usize chunk, usize column) const {
+				return chunks[chunk] + offsets[column];
+			}
+
+			void* Element(usize row, usize column) const {
+				return chunks[row / capacity] + offsets[column] + (row % capacity) * infos[column]->size;
+			}
+		};
+
+	public:
+
+		ArchetypeWorld();
+		~ArchetypeWorld();
+
+		ArchetypeWorld(const ArchetypeWorld&) = delete;
+		ArchetypeWorld& operator=(const ArchetypeWorld&) = delete;
+
+		/// Creates a new entity without components.
+		Entity Create();
+
+		/// Destroys an entity and all its components.
+		void Destroy(Entity entity);
+
+		/// Checks if the entity handle refers to an entity that has not been destroyed.
+		bool Valid(Entity entity) const;
+
+		/// Assigns a component to the given entity.
+		/// Moves all other components of the entity to the archetype that includes the new component.
+		template <typename Component>
+		Component& Assign(Entity entity)
+		{
+			static_assert(alignof(Component) <= ChunkAlignment);
+			FM_ASSERT(Valid(entity));
+
+			const ComponentInfo& info = ComponentType::Info<Component>();
+			Record& record = mRecords[EntityIndex(entity)];
+
+			FM_ASSERT(record.archetype->Find(info.id) < 0);
+
+			Move(entity, AddEdge(*record.archetype, info));
+
+			return Get<Component>(entity);
+		}
+
+		/// Removes a component from the given entity.
+		template <typename Component>
+		void Remove(Entity entity)
+		{
+			FM_ASSERT(Valid(entity));
+
+			const ComponentID id = ComponentType::ID<Component>();
+			Record& record = mRecords[EntityIndex(entity)];
+
+			FM_ASSERT(record.archetype->Find(id) >= 0);
+
+			Move(entity, RemoveEdge(*record.archetype, id));
+		}
+
+		/// Checks if an entity has all the given components.
+		template <typename... Component>
+		bool Has(Entity entity) const
+		{
+			if (!Valid(entity)) return false;
+
+			const Archetype* archetype = mRecords[EntityIndex(entity)].archetype;
+			return ((archetype->Find(ComponentType::ID<Component>()) >= 0) && ...);
+		}
+
+		/// Returns a component of the given entity, the entity must have it.
+		template <typename Component>
+		Component& Get(Entity entity)
+		{
+			FM_ASSERT(Valid(entity));
+
+			const Record& record = mRecords[EntityIndex(entity)];
+			const int column = record.archetype->Find(ComponentType::ID<Component>());
+
+			FM_ASSERT(column >= 0);
+
+			return *static_cast<Component*>(record.archetype->Element(record.row, column));
+		}
+
+		/// Calls func(const Entity* entities, usize count, Component*... components) for every chunk
+		/// that contains all given components. The arrays are contiguous and have count elements.
+		template <typename... Component, typename Func>
+		void EachChunk(Func func)
+		{
+			static_assert(sizeof...(Component) > 0);
+
+			const std::array<ComponentID, sizeof...(Component)> ids = { ComponentType::ID<Component>()... };
+
+			for (const auto& archetype : mArchetypes)
+			{
+				std::array<usize, sizeof...(Component)> columns;
+
+				if (archetype->size == 0 || !Match(*archetype, ids.data(), columns.data(), ids.size())) continue;
+
+				for (usize chunk = 0; chunk < archetype->chunks.size(); chunk++)
+				{
+					Invoke<Component...>(func, *archetype, chunk, columns, std::index_sequence_for<Component...>{});
+				}
+			}
+		}
+
+		/// Calls func(Entity entity, Component&... components) for every entity that has all given components.
+		template <typename... Component, typename Func>
+		void Each(Func func)
+		{
+			EachChunk<Component...>([&func](const Entity* entities, usize count, Component*... components) {
+				for (usize i = 0; i < count; i++)
+				{
+					func(entities[i], components[i]...);
+				}
+			});
+		}
+
+		/// Returns the number of alive entities.
+		usize Size() const {
+			return mEntities.size() - mFreeList.size();
+		}
+
+	private:
+
+		struct Record
+		{
+			Archetype* archetype;
+			usize row;
+		};
+
+		template <typename... Component, typename Func, std::size_t... I>
+		static void Invoke(Func& func, const Archetype& archetype, usize chunk, const std::array<usize, sizeof...(Component)>& columns, std::index_sequence<I...>)
+		{
+			func(archetype.Entities(chunk), archetype.Count(chunk), static_cast<Component*>(archetype.Column(chunk, columns[I]))...);
+		}
+
+		/// Looks up the columns of the given components, returns false if the archetype lacks any of them.
+		static bool Match(const Archetype& archetype, const ComponentID* ids, usize* columns, usize count);
+
+		Archetype* FindOrCreate(const std::vector<const ComponentInfo*>& infos);
+
+		Archetype* AddEdge(Archetype& archetype, const ComponentInfo& info);
+		Archetype* RemoveEdge(Archetype& archetype, ComponentID id);
+
+		/// Appends an entity to the archetype and returns its row, the components are left uninitialized.
+		usize Allocate(Archetype& archetype, Entity entity);
+
+		/// Destroys the components at the row and fills the hole with the last entity of the archetype.
+		void Free(Archetype& archetype, usize row);
+
+		/// Moves an entity and the components it shares with the target archetype, other target components are default constructed.
+		void Move(Entity entity, Archetype* to);
+
+	private:
+
+		std::vector<std::unique_ptr<Archetype>> mArchetypes;
+		std::map<std::vector<ComponentID>, Archetype*> mLookup;
+
+		Archetype* mRoot = nullptr;	///< Archetype without components.
+
+		std::vector<Entity> mEntities;	///< Current handle of every entity slot.
+		std::vector<Record> mRecords;	///< Location of every entity slot, parallel to mEntities.
+		std::vector<uint32> mFreeList;	///< Indices of destroyed entity slots.
+	};
+}
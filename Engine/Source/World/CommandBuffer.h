@@ -0,0 +1,155 @@
+// Copyright (c) 2020 Lauro Oyen, FmEngine contributors. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md for full terms. This notice is not to be removed.
+
+#pragma once
+
+#include "../Utility/CoreTypes.h"
+#include "../Utility/Assert.h"
+
+#include "World.h"
+
+#include <vector>
+#include <memory>
+#include <new>
+
+namespace FM
+{
+	/// Records structural changes to a World and applies them later in one batch.
+	/// Use this to create, destroy, assign or remove components while iterating a view,
+	/// since changing the pools directly would invalidate the iterators.
+	/// Commands are applied in the order they were recorded.
+
+	class CommandBuffer
+	{
+	public:
+
+		CommandBuffer(World& world)
+			: mWorld(world) {}
+
+		CommandBuffer(const CommandBuffer&) = delete;
+		CommandBuffer& operator=(const CommandBuffer&) = delete;
+
+		~CommandBuffer() {
+			Clear();
+		}
+
+		/// Creates a new entity.
+		/// The handle is allocated immediately as this doesn't touch any pool, its components are assigned on Execute().
+		Entity Create() {
+			return mWorld.Create();
+		}
+
+		/// Destroys an entity and all its components on Execute().
+		void Destroy(Entity entity)
+		{
+			mCommands.push_back({ [](World& world, Entity entity, void*) { world.Destroy(entity); }, nullptr, entity, nullptr });
+		}
+
+		/// Assigns a copy of the component to the given entity on Execute().
+		/// The component is move constructed in place, so it doesn't need a default constructor and observers see its value.
+		template <typename Component>
+		void Assign(Entity entity, Component component = {})
+		{
+			void* payload = new (Allocate(sizeof(Component), alignof(Component))) Component(std::move(component));
+
+			mCommands.push_back({
+				[](World& world, Entity entity, void* payload) { world.Assign<Component>(entity, std::move(*static_cast<Component*>(payload))); },
+				[](void* payload) { static_cast<Component*>(payload)->~Component(); },
+				entity, payload
+			});
+		}
+
+		/// Removes a component from the given entity on Execute().
+		template <typename Component>
+		void Remove(Entity entity)
+		{
+			mCommands.push_back({ [](World& world, Entity entity, void*) { world.Remove<Component>(entity); }, nullptr, entity, nullptr });
+		}
+
+		/// Applies all recorded commands to the world and clears the buffer.
+		/// Must be called at a sync point where no views of the world are being iterated.
+		void Execute()
+		{
+			for (Command& command : mCommands)
+			{
+				command.execute(mWorld, command.entity, command.payload);
+			}
+
+			Clear();
+		}
+
+		/// Discards all recorded commands without applying them.
+		/// Memory is kept to be reused by the next batch.
+		void Clear()
+		{
+			for (Command& command : mCommands)
+			{
+				if (command.destroy) command.destroy(command.payload);
+			}
+
+			mCommands.clear();
+
+			mBlock = 0;
+			mOffset = 0;
+		}
+
+		/// Returns the number of recorded commands.
+		usize Size() const {
+			return mCommands.size();
+		}
+
+	private:
+
+		struct Command
+		{
+			void (*execute)(World&, Entity, void*);
+			void (*destroy)(void*);
+			Entity entity;
+			void* payload;
+		};
+
+		struct Block
+		{
+			std::unique_ptr<uint8[]> data;
+			usize size;
+		};
+
+		static constexpr usize BlockSize = 16 * 1024;
+
+		/// Bump allocates payload memory. Blocks are never relocated, so payloads don't have to be trivially movable.
+		void* Allocate(usize size, usize alignment)
+		{
+			while (mBlock < mBlocks.size())
+			{
+				Block& block = mBlocks[mBlock];
+
+				const usize address = reinterpret_cast<usize>(block.data.get()) + mOffset;
+				const usize aligned = (address + alignment - 1) & ~(alignment - 1);
+
+				if (aligned + size <= reinterpret_cast<usize>(block.data.get()) + block.size)
+				{
+					mOffset = aligned + size - reinterpret_cast<usize>(block.data.get());
+					return reinterpret_cast<void*>(aligned);
+				}
+
+				mBlock++;
+				mOffset = 0;
+			}
+
+			const usize blockSize = size + alignment > BlockSize ? size + alignment : BlockSize;
+			mBlocks.push_back({ std::make_unique<uint8[]>(blockSize), blockSize });
+
+			return Allocate(size, alignment);
+		}
+
+	private:
+
+		World& mWorld;
+
+		std::vector<Command> mCommands;
+
+		std::vector<Block> mBlocks;
+		usize mBlock = 0;	///< Block that is currently being allocated from.
+		usize mOffset = 0;	///< Offset in bytes into the current block.
+	};
+}
@@ -0,0 +1,66 @@
+// Copyright (c) 2020 Lauro Oyen, FmEngine contributors. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md for full terms. This notice is not to be removed.
+
+#pragma once
+
+#include "../Utility/CoreTypes.h"
+
+#include <atomic>
+#include <new>
+#include <utility>
+
+namespace FM
+{
+	/// Sequential identifier of a component type, unique within the process.
+	using ComponentID = uint32;
+
+	/// Type-erased description of a component type.
+	/// Used by storage that doesn't know the component types at compile time.
+
+	struct ComponentInfo
+	{
+		ComponentID id;
+		usize size;
+		usize alignment;
+
+		void (*construct)(void* dst);			///< Default constructs a component.
+		void (*move)(void* dst, void* src);		///< Move constructs a component.
+		void (*destroy)(void* dst);				///< Destructs a component.
+	};
+
+	class ComponentType
+	{
+	public:
+
+		/// Returns the identifier of the component type.
+		/// Identifiers are handed out on first use and are thread-safe, they are not stable between runs.
+		template <typename T>
+		static ComponentID ID()
+		{
+			static const ComponentID id = Next();
+			return id;
+		}
+
+		/// Returns the type-erased description of the component type.
+		template <typename T>
+		static const ComponentInfo& Info()
+		{
+			static const ComponentInfo info = {
+				ID<T>(), sizeof(T), alignof(T),
+				[](void* dst) { new (dst) T(); },
+				[](void* dst, void* src) { new (dst) T(std::move(*static_cast<T*>(src))); },
+				[](void* dst) { static_cast<T*>(dst)->~T(); }
+			};
+
+			return info;
+		}
+
+	private:
+
+		static ComponentID Next()
+		{
+			static std::atomic<ComponentID> counter{ 0 };
+			return counter++;
+		}
+	};
+}
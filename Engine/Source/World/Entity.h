@@ -0,0 +1,35 @@
+// Copyright (c) 2020 Lauro Oyen, FmEngine contributors. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md for full terms. This notice is not to be removed.
+
+#pragma once
+
+#include "../Utility/CoreTypes.h"
+
+namespace FM
+{
+	/// Handle to an entity in a World.
+	/// The lower 32 bits are the index of the entity slot, the upper 32 bits are the version of that slot.
+	/// The version is incremented every time an entity is destroyed, so handles to recycled slots can be detected.
+	using Entity = uint64;
+
+	/// Handle that never refers to a valid entity.
+	inline constexpr Entity NullEntity = ~Entity(0);
+
+	/// Returns the slot index of an entity.
+	inline constexpr uint32 EntityIndex(Entity entity)
+	{
+		return static_cast<uint32>(entity);
+	}
+
+	/// Returns the version of an entity.
+	inline constexpr uint32 EntityVersion(Entity entity)
+	{
+		return static_cast<uint32>(entity >> 32);
+	}
+
+	/// Combines a slot index and version into an entity handle.
+	inline constexpr Entity MakeEntity(uint32 index, uint32 version)
+	{
+		return (static_cast<Entity>(version) << 32) | index;
+	}
+}
@@ -0,0 +1,224 @@
+// Copyright (c) 2020 Lauro Oyen, FmEngine contributors. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md for full terms. This notice is not to be removed.
+
+#pragma once
+
+#include "../Utility/CoreTypes.h"
+#include "../Utility/Assert.h"
+
+#include "Pool.h"
+
+#include "../Utility/Threading/JobSystem.h"
+
+#include <tuple>
+#include <algorithm>
+#include <vector>
+
+namespace FM
+{
+	/// Bookkeeping of an owning group, kept up to date by the World when components are assigned or removed.
+
+	class IGroup
+	{
+	public:
+
+		virtual ~IGroup() = default;
+
+		/// Checks if the pool is owned by this group.
+		virtual bool Owns(const IPool* pool) const = 0;
+
+		/// Must be called after a component of an owned pool was assigned to the entity.
+		virtual void OnAssign(Entity entity) = 0;
+
+		/// Must be called before a component of an owned pool is removed from the entity.
+		virtual void OnRemove(Entity entity) = 0;
+
+		/// Packs the group from scratch, for when the owned pools were replaced as a whole.
+		virtual void Refresh() = 0;
+
+		usize size = 0;	///< Number of entities in the group, they are at the front of every owned pool.
+	};
+
+	/// Keeps the entities that have all owned components packed at the front of every owned pool.
+	/// Entity i of the group is at dense index i in each owned pool, so the pools can be iterated in lockstep.
+	/// A pool can be owned by at most one group.
+
+	template <typename... Owned>
+	class GroupHandler final : public IGroup
+	{
+	public:
+
+		GroupHandler(ComponentPool<Owned>&... owned)
+			: pools{ &owned... }
+		{
+			Refresh();
+		}
+
+		bool Owns(const IPool* pool) const override
+		{
+			return ((std::get<ComponentPool<Owned>*>(pools) == pool) || ...);
+		}
+
+		void Refresh() override
+		{
+			size = 0;
+
+			const IPool* candidate = std::min({ static_cast<const IPool*>(std::get<ComponentPool<Owned>*>(pools))... }, [](const IPool* lhs, const IPool* rhs) {
+				return lhs->Size() < rhs->Size();
+			});
+
+			// Copy as OnAssign reorders the candidate.
+			const std::vector<Entity> entities = candidate->entities;
+
+			for (Entity entity : entities)
+			{
+				OnAssign(entity);
+			}
+		}
+
+		void OnAssign(Entity entity) override
+		{
+			if (!(std::get<ComponentPool<Owned>*>(pools)->Has(entity) && ...)) return;
+			if (Contains(entity)) return;
+
+			(std::get<ComponentPool<Owned>*>(pools)->Swap(std::get<ComponentPool<Owned>*>(pools)->Index(entity), size), ...);
+			size++;
+		}
+
+		void OnRemove(Entity entity) override
+		{
+			if (!Contains(entity)) return;
+
+			size--;
+			(std::get<ComponentPool<Owned>*>(pools)->Swap(std::get<ComponentPool<Owned>*>(pools)->Index(entity), size), ...);
+		}
+
+		/// Checks if the entity is part of the group.
+		bool Contains(Entity entity) const
+		{
+			const auto* pool = std::get<0>(pools);
+			return pool->Has(entity) && pool->Index(entity) < size;
+		}
+
+		std::tuple<ComponentPool<Owned>*...> pools;
+	};
+
+	/// Iterates the entities of an owning group.
+	/// Iteration is a plain indexed loop over the dense arrays of the owned pools.
+	/// All owned components that are iterated are marked as changed.
+
+	template <typename... Owned>
+	class Group
+	{
+	public:
+
+		Group(GroupHandler<Owned...>& handler)
+			: mHandler(&handler)
+		{}
+
+		/// Returns the number of entities in the group.
+		usize Size() const {
+			return mHandler->size;
+		}
+
+		const Entity* begin() const {
+			return std::get<0>(mHandler->pools)->entities.data();
+		}
+
+		const Entity* end() const {
+			return begin() + Size();
+		}
+
+		/// Returns a component of an entity that is part of this group.
+		template <typename Comp>
+		Comp& Get(const Entity entt) const {
+			return std::get<ComponentPool<Comp>*>(mHandler->pools)->Get(entt);
+		}
+
+		/// Calls func(Entity entity, Owned&... components) for every entity in the group.
+		template <typename Func>
+		void Each(Func func) const
+		{
+			EachRange(func, 0, Size());
+		}
+
+		/// Same as Each(), but splits the group into batches that are processed in parallel by the job system.
+		/// The callback must be safe to call concurrently for different entities.
+		template <typename Func>
+		void ParallelEach(Func func) const
+		{
+			GJobSystem.ParallelFor(Size(), GJobSystem.BatchSize(Size()), [&](usize begin, usize end) {
+				EachRange(func, begin, end);
+			});
+		}
+
+		/// Calls func(const Entity* entities, usize count, Owned*... components) with the packed arrays of the group.
+		/// The arrays are handed out at once, or split at the page boundaries of paged pools. Tags are passed as nullptr.
+		template <typename Func>
+		void EachChunk(Func func) const
+		{
+			MarkChanged(0, Size());
+
+			EachRun(0, Size(), func);
+		}
+
+	private:
+
+		template <typename Func>
+		void EachRange(Func& func, usize first, usize last) const
+		{
+			MarkChanged(first, last);
+
+			EachRun(first, last, [this, &func](const Entity* entities, usize count, Owned*... components) {
+				for (usize i = 0; i < count; i++)
+				{
+					func(entities[i], At<Owned>(components, i)...);
+				}
+			});
+		}
+
+		/// Returns the component at the offset in a chunk, tags have no chunk and return their shared instance.
+		template <typename Comp>
+		Comp& At(Comp* components, usize i) const
+		{
+			if constexpr (ComponentPool<Comp>::Tag)
+			{
+				return *std::get<ComponentPool<Comp>*>(mHandler->pools)->Data(0);
+			}
+			else
+			{
+				return components[i];
+			}
+		}
+
+		/// Calls func(entities, count, components...) for the runs in [first, last) that are contiguous in every owned pool.
+		template <typename Func>
+		void EachRun(usize first, usize last, Func&& func) const
+		{
+			const Entity* entities = begin();
+
+			while (first < last)
+			{
+				const usize count = std::min({ last - first, std::get<ComponentPool<Owned>*>(mHandler->pools)->Contiguous(first)... });
+
+				func(entities + first, count, std::get<ComponentPool<Owned>*>(mHandler->pools)->ChunkData(first)...);
+
+				first += count;
+			}
+		}
+
+		void MarkChanged(usize first, usize last) const
+		{
+			auto mark = [first, last](IPool* pool) {
+				std::fill(pool->ticks.begin() + first, pool->ticks.begin() + last, pool->tick);
+				pool->Touch();
+			};
+
+			(mark(std::get<ComponentPool<Owned>*>(mHandler->pools)), ...);
+		}
+
+	private:
+
+		GroupHandler<Owned...>* mHandler;
+	};
+}
@@ -0,0 +1,183 @@
+// Copyright (c) 2020 Lauro Oyen, FmEngine contributors. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md for full terms. This notice is not to be removed.
+
+#pragma once
+
+#include "../Utility/CoreTypes.h"
+#include "../Utility/Signal.h"
+
+#include "Entity.h"
+#include "World.h"
+
+#include <utility>
+#include <vector>
+
+namespace FM
+{
+	/// Collects the entities affected by component signals into a packed list, so a system only processes what changed.
+	/// Rules are added with OnConstruct(), OnUpdate() and OnDestroy(), the list is typically processed and cleared once per frame:
+	///
+	///     Observer added(world);
+	///     added.OnConstruct<StaticMesh>();
+	///     ...
+	///     added.Each([&](Entity entity) { ... });
+	///     added.Clear();
+	///
+	/// Every entity is collected at most once. The observer must be destroyed before the world it observes.
+
+	class Observer
+	{
+	public:
+
+		static constexpr uint32 Null = ~uint32(0);
+
+		Observer(World& world)
+			: mWorld(&world)
+		{}
+
+		Observer(const Observer&) = delete;
+		Observer& operator=(const Observer&) = delete;
+
+		~Observer()
+		{
+			Disconnect();
+		}
+
+		/// Collects the entities the component is assigned to.
+		/// Entities are dropped again when the component is removed before the list is cleared.
+		template <typename Component>
+		Observer& OnConstruct()
+		{
+			Connect(mWorld->OnConstruct<Component>(), &Insert);
+			Connect(mWorld->OnDestroy<Component>(), &Erase);
+			return *this;
+		}
+
+		/// Collects the entities of which the component is patched.
+		/// Entities are dropped again when the component is removed before the list is cleared.
+		template <typename Component>
+		Observer& OnUpdate()
+		{
+			Connect(mWorld->OnUpdate<Component>(), &Insert);
+			Connect(mWorld->OnDestroy<Component>(), &Erase);
+			return *this;
+		}
+
+		/// Collects the entities the component is removed from, including destroyed entities.
+		template <typename Component>
+		Observer& OnDestroy()
+		{
+			Connect(mWorld->OnDestroy<Component>(), &Insert);
+			return *this;
+		}
+
+		/// Stops collecting entities, the collected entities are kept.
+		void Disconnect()
+		{
+			for (auto& [signal, callback] : mConnections)
+			{
+				signal->Disconnect(callback, this);
+			}
+
+			mConnections.clear();
+		}
+
+		/// Returns the number of collected entities.
+		usize Size() const {
+			return entities.size();
+		}
+
+		bool Empty() const {
+			return entities.empty();
+		}
+
+		const Entity* begin() const {
+			return entities.data();
+		}
+
+		const Entity* end() const {
+			return entities.data() + entities.size();
+		}
+
+		/// Calls func(Entity entity) for every collected entity.
+		/// The callback must not modify the observed components in a way that triggers the observer.
+		template <typename Func>
+		void Each(Func func) const
+		{
+			for (Entity entity : entities)
+			{
+				func(entity);
+			}
+		}
+
+		/// Removes all collected entities.
+		void Clear()
+		{
+			for (Entity entity : entities)
+			{
+				lookup[EntityIndex(entity)] = Null;
+			}
+
+			entities.clear();
+		}
+
+	public:
+
+		std::vector<Entity> entities;	///< Collected entities, in the order they were first collected unless one was dropped.
+
+	private:
+
+		void Connect(TSignal<Entity>& signal, TSignal<Entity>::Callback callback)
+		{
+			signal.Connect(callback, this);
+			mConnections.emplace_back(&signal, callback);
+		}
+
+		/// An entity slot holds at most one handle, a newer version of the entity replaces an older one.
+		static void Insert(Entity entity, void* user)
+		{
+			Observer& observer = *static_cast<Observer*>(user);
+			const uint32 index = EntityIndex(entity);
+
+			if (!(index < observer.lookup.size()))
+			{
+				observer.lookup.resize(index + 1, Null);
+			}
+
+			if (observer.lookup[index] == Null)
+			{
+				observer.lookup[index] = static_cast<uint32>(observer.entities.size());
+				observer.entities.push_back(entity);
+			}
+			else
+			{
+				observer.entities[observer.lookup[index]] = entity;
+			}
+		}
+
+		static void Erase(Entity entity, void* user)
+		{
+			Observer& observer = *static_cast<Observer*>(user);
+			const uint32 index = EntityIndex(entity);
+
+			if (!(index < observer.lookup.size()) || observer.lookup[index] == Null) return;
+			if (observer.entities[observer.lookup[index]] != entity) return;
+
+			// Swap and pop.
+			const uint32 position = observer.lookup[index];
+			const Entity last = observer.entities.back();
+
+			observer.entities[position] = last;
+			observer.lookup[EntityIndex(last)] = position;
+
+			observer.entities.pop_back();
+			observer.lookup[index] = Null;
+		}
+
+	private:
+
+		World* mWorld;
+		std::vector<std::pair<TSignal<Entity>*, TSignal<Entity>::Callback>> mConnections;
+		std::vector<uint32> lookup;		///< Position in entities of every entity slot, or Null if the slot isn't collected.
+	};
+}
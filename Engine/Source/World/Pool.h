@@ -6,58 +6,645 @@
 #include "../Utility/CoreTypes.h"
 #include "../Utility/Assert.h"
 
+#include "../Utility/Memory.h"
+#include "../Utility/Containers/PagedArray.h"
+#include "../Utility/Signal.h"
+
+#include "Entity.h"
+
 #include <vector>
-#include <unordered_map>
 #include <memory>
+#include <atomic>
+#include <algorithm>
+#include <concepts>
+#include <type_traits>
+#include <utility>
 
 namespace FM
 {
-	using Entity = uint64;
+	enum class ESortAlgorithm
+	{
+		Full,		///< Sorts from scratch in O(n log n).
+		Insertion	///< Insertion sort, close to O(n) if the pool is nearly sorted already, like when it was sorted the previous frame.
+	};
+
+	/// Sparse set of entities shared by all component pools.
+	/// The sparse array is split into fixed size pages that are only allocated when an entity in their range is stored,
+	/// this way membership tests and index lookups are a couple of array loads without paying for unused entity ranges.
+
+	class IPool
+	{
+	public:
+
+		static constexpr usize PageSize = 4096;	///< Number of sparse entries per page.
+		static constexpr uint32 Null = ~uint32(0);	///< Sparse entry of an entity that is not in the set.
+
+		virtual ~IPool() = default;
+
+		/// Returns the position of the entity in the dense arrays, or Null if the entity is not part of this set.
+		/// Stale handles to a recycled entity slot are not part of the set.
+		usize Find(Entity entity) const
+		{
+			const usize page = EntityIndex(entity) / PageSize;
+
+			if (!(page < sparse.size() && sparse[page])) return Null;
+
+			const uint32 index = sparse[page][EntityIndex(entity) % PageSize];
+			return (index != Null && entities[index] == entity) ? index : Null;
+		}
+
+		/// Checks if the entity is part of this set.
+		bool Has(Entity entity) const {
+			return Find(entity) != Null;
+		}
+
+		/// Returns the position of the entity in the dense arrays, the entity must be part of this set.
+		usize Index(Entity entity) const {
+			FM_ASSERT(Has(entity));
+			return sparse[EntityIndex(entity) / PageSize][EntityIndex(entity) % PageSize];
+		}
+
+		/// Removes the entity and its data from this set.
+		virtual void Remove(Entity entity) = 0;
+
+		/// Swaps two entities and their data in the dense arrays.
+		virtual void Swap(usize lhs, usize rhs) = 0;
+
+		/// Returns a new pool of the same type with a copy of the entities, ticks and components of this pool.
+		/// Signals are not copied.
+		virtual std::unique_ptr<IPool> Clone() const = 0;
+
+		/// Replaces the entities, ticks and components with a copy of those of another pool of the same type.
+		/// Reuses the allocated memory, signals are neither copied nor emitted.
+		virtual void CopyFrom(const IPool& other) = 0;
+
+		/// Checks if a pool of the same type holds the same entities, ticks and components, so it doesn't need to be copied.
+		/// Pools of components that are neither trivially copyable nor equality comparable never match.
+		virtual bool Matches(const IPool& other) const = 0;
+
+		/// Removes all entities and their data without emitting signals.
+		virtual void Clear() = 0;
+
+		/// Reorders this set so the entities it shares with the other set come first, in the order of the other set.
+		/// The order of the remaining entities is undefined.
+		void SortAs(const IPool& other)
+		{
+			usize pos = 0;
+
+			for (Entity entity : other.entities)
+			{
+				const usize index = Find(entity);
+
+				if (index != Null)
+				{
+					// The entities before pos are already placed, so the index is never below it.
+					Swap(index, pos++);
+				}
+			}
+		}
+
+		/// Reserves the dense arrays for the given number of entities.
+		virtual void Reserve(usize capacity)
+		{
+			entities.reserve(capacity);
+			ticks.reserve(capacity);
+		}
+
+		usize Size() const {
+			return entities.size();
+		}
+
+		/// Checks if the component at the dense index was changed after the given tick.
+		bool ChangedAt(usize index, uint32 since) const {
+			return ticks[index] > since;
+		}
+
+		/// Checks if the entity is part of this set and its component was changed after the given tick.
+		bool Changed(Entity entity, uint32 since) const {
+			const usize index = Find(entity);
+			return index != Null && ChangedAt(index, since);
+		}
+
+		/// Stamps the component at the dense index with the current tick.
+		void MarkChanged(usize index) {
+			ticks[index] = tick;
+			Touch();
+		}
+
+		/// Invalidates the revision, must be called whenever the entities or components are modified through the pool.
+		/// Only stores if needed, so concurrent calls from parallel iteration don't contend on the cache line.
+		void Touch() {
+			FM_ASSERT(readers.load(std::memory_order_relaxed) == 0);
+			if (revision.load(std::memory_order_relaxed) != 0) revision.store(0, std::memory_order_relaxed);
+		}
+
+		std::vector<Entity> entities;
+		std::vector<uint32> ticks;	///< Tick at which each component was assigned or last accessed mutably, parallel to entities.
+		uint32 tick = 0;			///< Current tick of the world, stamped on components that are changed.
 
-	class IPool {};
+		TSignal<Entity> onConstruct;	///< Emitted after a component was assigned to the entity.
+		TSignal<Entity> onUpdate;		///< Emitted after the component of the entity was patched.
+		TSignal<Entity> onDestroy;		///< Emitted before the component of the entity is removed.
+
+		/// Identifies the contents of the pool, 0 if unknown. Writes through a component reference that is kept around don't reset it,
+		/// so only pools of components with ComponentTraits::TrackedWrites rely on it, see Matches() and World::Save().
+		std::atomic<uint64> revision = 0;
+
+		/// Number of running systems that declared the component as only read, it must not be modified meanwhile. See Scheduler.
+		std::atomic<uint32> readers = 0;
+
+	protected:
+
+		/// Appends the entity to the dense array and returns its position.
+		usize Emplace(Entity entity)
+		{
+			FM_ASSERT(!Has(entity));
+
+			const usize index = entities.size();
+
+			Assure(EntityIndex(entity) / PageSize)[EntityIndex(entity) % PageSize] = static_cast<uint32>(index);
+			entities.push_back(entity);
+			ticks.push_back(tick);
+			Touch();
+
+			return index;
+		}
+
+		/// Appends count entities to the dense array, which must not be part of the set yet.
+		void Emplace(const Entity* first, usize count)
+		{
+			// Grow geometrically, so repeated small batches don't reallocate every time.
+			if (entities.capacity() < entities.size() + count)
+			{
+				Reserve(std::max<usize>(entities.size() + count, 2 * entities.capacity()));
+			}
+
+			usize page = ~usize(0);
+			uint32* sparsePage = nullptr;
+
+			for (usize i = 0; i < count; i++)
+			{
+				const Entity entity = first[i];
+
+				FM_ASSERT(entity != NullEntity && !Has(entity));
+
+				if (EntityIndex(entity) / PageSize != page)
+				{
+					page = EntityIndex(entity) / PageSize;
+					sparsePage = Assure(page);
+				}
+
+				sparsePage[EntityIndex(entity) % PageSize] = static_cast<uint32>(entities.size());
+				entities.push_back(entity);
+			}
+
+			ticks.resize(entities.size(), tick);
+			Touch();
+		}
+
+		/// Removes the entity by moving the last entity into its place.
+		void Erase(Entity entity)
+		{
+			const usize index = Index(entity);
+			const Entity last = entities.back();
+
+			entities[index] = last;
+			ticks[index] = ticks.back();
+			sparse[EntityIndex(last) / PageSize][EntityIndex(last) % PageSize] = static_cast<uint32>(index);
+			sparse[EntityIndex(entity) / PageSize][EntityIndex(entity) % PageSize] = Null;
+
+			entities.pop_back();
+			ticks.pop_back();
+			Touch();
+		}
+
+		/// Swaps two entities in the dense array and updates their sparse entries.
+		void SwapEntities(usize lhs, usize rhs)
+		{
+			std::swap(entities[lhs], entities[rhs]);
+			std::swap(ticks[lhs], ticks[rhs]);
+
+			sparse[EntityIndex(entities[lhs]) / PageSize][EntityIndex(entities[lhs]) % PageSize] = static_cast<uint32>(lhs);
+			sparse[EntityIndex(entities[rhs]) / PageSize][EntityIndex(entities[rhs]) % PageSize] = static_cast<uint32>(rhs);
+			Touch();
+		}
+
+		/// Copies the entities, ticks and sparse pages of another set.
+		void CopySet(const IPool& other)
+		{
+			entities = other.entities;
+			ticks = other.ticks;
+
+			if (sparse.size() < other.sparse.size())
+			{
+				sparse.resize(other.sparse.size());
+			}
+
+			for (usize page = 0; page < sparse.size(); page++)
+			{
+				if (page < other.sparse.size() && other.sparse[page])
+				{
+					Memory::Memcpy(Assure(page), other.sparse[page].get(), PageSize * sizeof(uint32));
+				}
+				else if (sparse[page])
+				{
+					std::fill_n(sparse[page].get(), PageSize, Null);
+				}
+			}
+
+			Touch();
+		}
+
+		/// Checks if another set holds the same entities and ticks.
+		/// The sparse pages always mirror the entities, so they don't need to be compared.
+		bool MatchesSet(const IPool& other) const
+		{
+			return entities == other.entities && ticks == other.ticks;
+		}
+
+		/// Removes all entities, the sparse pages are kept.
+		void ClearSet()
+		{
+			for (Entity entity : entities)
+			{
+				sparse[EntityIndex(entity) / PageSize][EntityIndex(entity) % PageSize] = Null;
+			}
+
+			entities.clear();
+			ticks.clear();
+			Touch();
+		}
+
+	private:
+
+		uint32* Assure(usize page)
+		{
+			if (!(page < sparse.size()))
+			{
+				sparse.resize(page + 1);
+			}
+
+			if (!sparse[page])
+			{
+				sparse[page] = std::make_unique<uint32[]>(PageSize);
+				std::fill_n(sparse[page].get(), PageSize, Null);
+			}
+
+			return sparse[page].get();
+		}
+
+		std::vector<std::unique_ptr<uint32[]>> sparse;
+	};
+
+	/// Storage options of a component type, specialize to change them.
+
+	template <typename T>
+	struct ComponentTraits
+	{
+		/// Stores the components in pages that are never relocated, instead of a single array.
+		/// References to a component then stay valid when other components are assigned, and growing the pool
+		/// doesn't copy all components. Removing a component still moves the last component of the pool into its place.
+		static constexpr bool Paged = false;
+
+		/// Promises that the components are only modified through the world, its views and groups, never through a
+		/// reference that is kept across World::Save() or World::Restore(). Snapshots then skip the pool when its revision
+		/// is unchanged, instead of comparing its contents.
+		static constexpr bool TrackedWrites = false;
+	};
+
+	/// Stores a component for every entity in the set.
+	/// Empty types are tags: their pool only keeps the set of entities, all entities share a single instance.
 
 	template <typename T>
 	class ComponentPool : public IPool
 	{
 	public:
 
-		T& Assign(Entity entity)
+		static constexpr bool Tag = std::is_empty_v<T>;
+		static constexpr bool Paged = ComponentTraits<T>::Paged && !Tag;
+
+		struct NoStorage {};
+
+		using storage_type = std::conditional_t<Tag, NoStorage, std::conditional_t<Paged, TPagedArray<T>, std::vector<T>>>;
+
+		/// Constructs the component of the entity in place from the given arguments.
+		/// Aggregates are initialized with braces.
+		template <typename... Args>
+		T& Assign(Entity entity, Args&&... args)
 		{
-			FM_ASSERT(entity != 0);
-			FM_ASSERT(lookup.find(entity) == lookup.end());
+			FM_ASSERT(entity != NullEntity);
 
-			lookup[entity] = components.size();
+			Emplace(entity);
 
-			components.emplace_back();
-			entities.push_back(entity);
+			T& component = Construct(std::forward<Args>(args)...);
+
+			onConstruct.Emit(entity);
+
+			return component;
+		}
+
+		/// Assigns a copy of the prototype to count entities, a plain fill for trivially copyable components.
+		void Assign(const Entity* first, usize count, const T& prototype)
+		{
+			Emplace(first, count);
 
-			return components.back();
+			if constexpr (!Tag)
+			{
+				components.resize(components.size() + count, prototype);
+			}
+
+			EmitConstruct(first, count);
 		}
 
-		void Remove(Entity entity)
+		/// Assigns count components to count entities, copied from the array with a single memcpy for trivially copyable components.
+		void Assign(const Entity* first, usize count, const T* values)
 		{
-			FM_ASSERT(false); // TODO: Not implemented.
+			Emplace(first, count);
+
+			if constexpr (Paged)
+			{
+				components.append(values, count);
+			}
+			else if constexpr (!Tag)
+			{
+				components.insert(components.end(), values, values + count);
+			}
+
+			EmitConstruct(first, count);
 		}
 
-		bool Has(Entity entity) const {
-			return lookup.find(entity) != lookup.end();
+		void Reserve(usize capacity) override
+		{
+			IPool::Reserve(capacity);
+
+			if constexpr (!Tag)
+			{
+				components.reserve(capacity);
+			}
 		}
 
-		usize Size() {
-			return components.size();
+		/// Removes the component in O(1) by moving the last component into its place.
+		/// This changes the order of the dense arrays.
+		void Remove(Entity entity) override
+		{
+			onDestroy.Emit(entity);
+
+			if constexpr (!Tag)
+			{
+				const usize index = Index(entity);
+
+				if (index != components.size() - 1)
+				{
+					components[index] = std::move(components.back());
+				}
+
+				components.pop_back();
+			}
+
+			Erase(entity);
 		}
 
-		T& Get(Entity entity)
+		void Swap(usize lhs, usize rhs) override
 		{
-			auto it = lookup.find(entity);
-			if (it != lookup.end())
+			if (lhs == rhs) return;
+
+			if constexpr (!Tag)
 			{
-				return components[it->second];
+				std::swap(components[lhs], components[rhs]);
 			}
+
+			SwapEntities(lhs, rhs);
 		}
 
-		std::vector<T> components;
-		std::vector<Entity> entities;
-		std::unordered_map<Entity, usize> lookup;
+		std::unique_ptr<IPool> Clone() const override
+		{
+			auto pool = std::make_unique<ComponentPool<T>>();
+			pool->CopyFrom(*this);
+			return pool;
+		}
+
+		void CopyFrom(const IPool& other) override
+		{
+			CopySet(other);
+
+			if constexpr (!Tag && std::is_copy_assignable_v<T>)
+			{
+				components = static_cast<const ComponentPool<T>&>(other).components;
+			}
+			else if constexpr (!Tag)
+			{
+				FM_ASSERT(false);	// Components that can't be copied can't be part of a snapshot.
+			}
+		}
+
+		bool Matches(const IPool& other) const override
+		{
+			if constexpr (ComponentTraits<T>::TrackedWrites)
+			{
+				if (revision != 0 && revision == other.revision) return true;
+			}
+
+			if (!MatchesSet(other)) return false;
+
+			if constexpr (Tag)
+			{
+				return true;
+			}
+			else if constexpr (std::is_trivially_copyable_v<T>)
+			{
+				// Padding bytes may differ even if the values don't, which only costs a redundant copy.
+				const storage_type& rhs = static_cast<const ComponentPool<T>&>(other).components;
+
+				for (usize i = 0; i < Size(); i += Contiguous(i))
+				{
+					if (Memory::Memcmp(Data(i), &rhs[i], Contiguous(i) * sizeof(T)) != 0) return false;
+				}
+
+				return true;
+			}
+			else if constexpr (std::equality_comparable<T>)
+			{
+				const storage_type& rhs = static_cast<const ComponentPool<T>&>(other).components;
+
+				for (usize i = 0; i < Size(); i++)
+				{
+					if (!(components[i] == rhs[i])) return false;
+				}
+
+				return true;
+			}
+			else
+			{
+				return false;
+			}
+		}
+
+		void Clear() override
+		{
+			ClearSet();
+
+			if constexpr (!Tag)
+			{
+				components.clear();
+			}
+		}
+
+		/// Sorts the entities and their components in place, so compare(const T& lhs, const T& rhs) holds for consecutive components.
+		/// The sparse index is kept up to date, the change ticks move along with their components.
+		template <typename Compare>
+		void Sort(Compare compare, ESortAlgorithm algorithm = ESortAlgorithm::Full)
+		{
+			static_assert(!Tag, "Tags have no components to sort by.");
+
+			const usize size = Size();
+
+			if (algorithm == ESortAlgorithm::Insertion)
+			{
+				for (usize i = 1; i < size; i++)
+				{
+					for (usize j = i; j > 0 && compare(components[j], components[j - 1]); j--)
+					{
+						Swap(j, j - 1);
+					}
+				}
+
+				return;
+			}
+
+			// Sort a permutation and apply it by following its cycles, so every element is moved only once.
+
+			std::vector<usize> order(size);
+
+			for (usize i = 0; i < size; i++)
+			{
+				order[i] = i;
+			}
+
+			std::sort(order.begin(), order.end(), [this, &compare](usize lhs, usize rhs) {
+				return compare(components[lhs], components[rhs]);
+			});
+
+			for (usize i = 0; i < size; i++)
+			{
+				usize curr = i;
+				usize next = order[curr];
+
+				while (next != i)
+				{
+					Swap(curr, next);
+					order[curr] = curr;
+					curr = next;
+					next = order[curr];
+				}
+
+				order[curr] = curr;
+			}
+		}
+
+		/// Calls func(T& component) to modify the component of the entity, then marks it as changed and emits onUpdate.
+		template <typename Func>
+		T& Patch(Entity entity, Func func)
+		{
+			T& component = Get(entity);
+			func(component);
+			onUpdate.Emit(entity);
+			return component;
+		}
+
+		/// Returns the component of the entity and marks it as changed.
+		/// Unlike Patch(), this doesn't emit onUpdate.
+		T& Get(Entity entity) {
+			const usize index = Index(entity);
+			MarkChanged(index);
+			return *Data(index);
+		}
+
+		const T& Get(Entity entity) const {
+			return *Data(Index(entity));
+		}
+
+		/// Returns the component of the entity without marking it as changed.
+		const T& Read(Entity entity) const {
+			return *Data(Index(entity));
+		}
+
+		/// Returns a pointer to the component at the dense index.
+		/// Tags return the shared instance for every index.
+		T* Data(usize index)
+		{
+			if constexpr (Tag)
+			{
+				return &Instance();
+			}
+			else
+			{
+				return &components[index];
+			}
+		}
+
+		const T* Data(usize index) const {
+			return const_cast<ComponentPool*>(this)->Data(index);
+		}
+
+		/// Returns a pointer to the components from the dense index on, as an array for chunk callbacks.
+		/// Tags have no array and return nullptr.
+		T* ChunkData(usize index) {
+			if constexpr (Tag) return nullptr;
+			else return Data(index);
+		}
+
+		const T* ChunkData(usize index) const {
+			return const_cast<ComponentPool*>(this)->ChunkData(index);
+		}
+
+		/// Returns the number of components from the dense index on that are stored contiguously.
+		usize Contiguous(usize index) const
+		{
+			if constexpr (Paged)
+			{
+				return std::min(Size() - index, storage_type::ElementsPerPage - index % storage_type::ElementsPerPage);
+			}
+			else
+			{
+				return Size() - index;
+			}
+		}
+
+		storage_type components;	///< Empty for tags.
+
+	private:
+
+		template <typename... Args>
+		T& Construct(Args&&... args)
+		{
+			if constexpr (Tag)
+			{
+				return Instance();
+			}
+			else if constexpr (std::is_aggregate_v<T>)
+			{
+				return components.emplace_back(T{ std::forward<Args>(args)... });
+			}
+			else
+			{
+				return components.emplace_back(std::forward<Args>(args)...);
+			}
+		}
+
+		void EmitConstruct(const Entity* first, usize count) const
+		{
+			if (onConstruct.Empty()) return;
+
+			for (usize i = 0; i < count; i++)
+			{
+				onConstruct.Emit(first[i]);
+			}
+		}
+
+		static T& Instance()
+		{
+			static T instance;
+			return instance;
+		}
 	};
 }
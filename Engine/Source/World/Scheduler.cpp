@@ -0,0 +1,174 @@
+// Copyright (c) 2020 Lauro Oyen, FmEngine contributors. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md for full terms. This notice is not to be removed.
+
+#include "Scheduler.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace FM
+{
+	namespace
+	{
+		uint64 Now()
+		{
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+
+		bool Intersects(const std::vector<ComponentID>& lhs, const std::vector<ComponentID>& rhs)
+		{
+			auto l = lhs.begin();
+			auto r = rhs.begin();
+
+			while (l != lhs.end() && r != rhs.end())
+			{
+				if (*l < *r) l++;
+				else if (*r < *l) r++;
+				else return true;
+			}
+
+			return false;
+		}
+	}
+
+	void Scheduler::Insert(std::vector<ComponentID>& ids, ComponentID id)
+	{
+		auto it = std::lower_bound(ids.begin(), ids.end(), id);
+		if (it == ids.end() || *it != id) ids.insert(it, id);
+	}
+
+	bool Scheduler::Conflicts(const System& lhs, const System& rhs)
+	{
+		return Intersects(lhs.writes, rhs.writes) || Intersects(lhs.writes, rhs.reads) || Intersects(lhs.reads, rhs.writes);
+	}
+
+	void Scheduler::Run(World& world)
+	{
+		if (mSystems.empty()) return;
+
+		Build();
+
+		for (auto& system : mSystems)
+		{
+			system->prepare(world);
+		}
+
+		JobCounter counter;
+
+		mWorld = &world;
+		mCounter = &counter;
+		mStartTime = Now();
+
+		for (usize i = 0; i < mSystems.size(); i++)
+		{
+			if (mSystems[i]->dependencies.empty()) Launch(i);
+		}
+
+		GJobSystem.Wait(counter);
+
+		mWorld = nullptr;
+		mCounter = nullptr;
+
+		ComputeCriticalPath();
+	}
+
+	void Scheduler::Build()
+	{
+		for (auto& system : mSystems)
+		{
+			system->dependencies.clear();
+			system->dependents.clear();
+		}
+
+		for (usize i = 0; i < mSystems.size(); i++)
+		{
+			for (usize j = 0; j < i; j++)
+			{
+				if (Conflicts(*mSystems[i], *mSystems[j]))
+				{
+					mSystems[i]->dependencies.push_back(j);
+					mSystems[j]->dependents.push_back(i);
+				}
+			}
+
+			mSystems[i]->pending.store(mSystems[i]->dependencies.size(), std::memory_order_relaxed);
+		}
+	}
+
+	void Scheduler::Launch(usize system)
+	{
+		GJobSystem.Run([this, system]() { Execute(system); }, mCounter);
+	}
+
+	void Scheduler::Execute(usize index)
+	{
+		System& system = *mSystems[index];
+
+		const float start = Elapsed();
+
+		for (ComponentID id : system.reads)
+		{
+			mWorld->FindPool(id)->readers.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		system.func(*mWorld);
+
+		for (ComponentID id : system.reads)
+		{
+			mWorld->FindPool(id)->readers.fetch_sub(1, std::memory_order_relaxed);
+		}
+
+		system.timing.start = start;
+		system.timing.duration = Elapsed() - start;
+
+		// The job of this system is still counted, so the frame can't finish before the dependents are launched.
+		for (usize dependent : system.dependents)
+		{
+			if (mSystems[dependent]->pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			{
+				Launch(dependent);
+			}
+		}
+	}
+
+	void Scheduler::ComputeCriticalPath()
+	{
+		// Dependencies always precede their dependents, so a single pass in order finds the longest chain ending at every system.
+
+		std::vector<float> finish(mSystems.size());
+		std::vector<usize> previous(mSystems.size(), ~usize(0));
+
+		usize last = 0;
+
+		for (usize i = 0; i < mSystems.size(); i++)
+		{
+			float start = 0.0f;
+
+			for (usize dependency : mSystems[i]->dependencies)
+			{
+				if (finish[dependency] > start)
+				{
+					start = finish[dependency];
+					previous[i] = dependency;
+				}
+			}
+
+			finish[i] = start + mSystems[i]->timing.duration;
+			mSystems[i]->timing.critical = false;
+
+			if (finish[i] > finish[last]) last = i;
+		}
+
+		mCriticalPath = finish[last];
+
+		for (usize i = last; i != ~usize(0); i = previous[i])
+		{
+			mSystems[i]->timing.critical = true;
+		}
+	}
+
+	float Scheduler::Elapsed() const
+	{
+		return (Now() - mStartTime) * 1e-9f;
+	}
+}
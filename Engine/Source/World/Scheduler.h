@@ -0,0 +1,148 @@
+// Copyright (c) 2020 Lauro Oyen, FmEngine contributors. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md for full terms. This notice is not to be removed.
+
+#pragma once
+
+#include "../Utility/CoreTypes.h"
+
+#include "World.h"
+#include "ComponentType.h"
+
+#include "../Utility/Threading/JobSystem.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace FM
+{
+	/// Declares the components a system only reads, Reads<T> and Reads<const T> are the same.
+	/// The system must only access them as const, e.g. through GetView<const T>(). Mutable access stamps the change ticks,
+	/// which races with other readers, and is caught by an assert while the system runs.
+	template <typename... Component>
+	struct Reads
+	{
+		static void Prepare(World& world) {
+			world.Prepare<Component...>();
+		}
+	};
+
+	/// Declares the components a system reads and writes.
+	template <typename... Component>
+	struct Writes
+	{
+		static void Prepare(World& world) {
+			world.Prepare<Component...>();
+		}
+	};
+
+	/// Runs systems in parallel on the job system, based on the components they access.
+	/// Two systems conflict if one of them writes a component the other one reads or writes.
+	/// Conflicting systems run in the order they were added, all others may run at the same time.
+	/// Systems must not access components they haven't declared, or create and destroy entities.
+
+	class Scheduler
+	{
+	public:
+
+		using SystemFunc = std::function<void(World& world)>;
+
+		/// Timing of a system during the last frame, in seconds.
+		struct Timing
+		{
+			float start = 0.0f;			///< Time since the start of Run() at which the system started.
+			float duration = 0.0f;		///< Time spent executing the system.
+			bool critical = false;		///< The system lies on the critical path.
+		};
+
+		/// Adds a system that is executed by every call to Run().
+		/// The access is declared with Reads<...> and Writes<...>, for example Add<Reads<Transform>, Writes<Rigidbody>>(name, func).
+		template <typename... Access>
+		void Add(const char* name, SystemFunc func)
+		{
+			auto system = std::make_unique<System>();
+			system->name = name;
+			system->func = std::move(func);
+			system->prepare = [](World& world) { (Access::Prepare(world), ...); };
+
+			(Declare(*system, Access{}), ...);
+
+			mSystems.push_back(std::move(system));
+		}
+
+		/// Builds the dependency graph and executes all systems, returns when all of them are done.
+		void Run(World& world);
+
+		/// Returns the number of systems.
+		usize Size() const {
+			return mSystems.size();
+		}
+
+		const char* GetName(usize system) const {
+			return mSystems[system]->name;
+		}
+
+		const Timing& GetTiming(usize system) const {
+			return mSystems[system]->timing;
+		}
+
+		/// Returns the duration of the longest chain of dependent systems during the last frame, in seconds.
+		/// This is the lower bound of the time Run() takes, regardless of the number of threads.
+		float GetCriticalPath() const {
+			return mCriticalPath;
+		}
+
+	private:
+
+		struct System
+		{
+			const char* name;
+			SystemFunc func;
+			void (*prepare)(World& world);	///< Creates the pools of the accessed components up front, pools can't be created concurrently.
+
+			std::vector<ComponentID> reads;		///< Sorted identifiers of the components that are only read.
+			std::vector<ComponentID> writes;	///< Sorted identifiers of the components that are written.
+
+			std::vector<usize> dependencies;	///< Earlier systems that conflict with this one.
+			std::vector<usize> dependents;		///< Later systems that conflict with this one.
+			std::atomic<usize> pending{ 0 };	///< Number of dependencies that didn't finish yet this frame.
+
+			Timing timing;
+		};
+
+		template <typename... Component>
+		static void Declare(System& system, Reads<Component...>) {
+			(Insert(system.reads, ComponentType::ID<std::remove_const_t<Component>>()), ...);
+		}
+
+		template <typename... Component>
+		static void Declare(System& system, Writes<Component...>) {
+			(Insert(system.writes, ComponentType::ID<std::remove_const_t<Component>>()), ...);
+		}
+
+		static void Insert(std::vector<ComponentID>& ids, ComponentID id);
+
+		static bool Conflicts(const System& lhs, const System& rhs);
+
+		void Build();
+
+		void Launch(usize system);
+
+		void Execute(usize system);
+
+		void ComputeCriticalPath();
+
+		float Elapsed() const;
+
+	private:
+
+		std::vector<std::unique_ptr<System>> mSystems;
+
+		World* mWorld = nullptr;
+		JobCounter* mCounter = nullptr;
+		uint64 mStartTime = 0;
+		float mCriticalPath = 0.0f;
+	};
+}
@@ -0,0 +1,258 @@
+// Copyright (c) 2020 Lauro Oyen, FmEngine contributors. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md for full terms. This notice is not to be removed.
+
+#include "Serialization.h"
+
+#include "../Modules/Windows/MappedFile.h"
+#include "../Utility/Logger/Log.h"
+
+#include <algorithm>
+#include <fstream>
+#include <vector>
+
+namespace FM
+{
+	static uint64 AlignSection(uint64 offset)
+	{
+		return (offset + WorldFile::SectionAlignment - 1) & ~uint64(WorldFile::SectionAlignment - 1);
+	}
+
+	/// Writes zeros up to the offset, which is at most one section alignment away.
+	static void PadTo(std::ofstream& file, uint64 offset)
+	{
+		static const char zeros[WorldFile::SectionAlignment] = {};
+		file.write(zeros, offset - static_cast<uint64>(file.tellp()));
+	}
+
+	/// Checks if count elements of the given size at the offset lie within the file.
+	static bool InFile(uint64 offset, uint64 count, uint64 size, usize fileSize)
+	{
+		return offset <= fileSize && count <= (fileSize - offset) / (size ? size : 1);
+	}
+
+	/// Checks that the loaded entities can be trusted before anything is written into the world: every slot holds a handle
+	/// with its own index, free slots are unique and in range, every component type has a single pool, and every pool only
+	/// refers to live entities, each at most once.
+	static bool ValidEntities(const WorldFileHeader& header, const Entity* slots, const uint32* freeSlots, const WorldFilePool* table, const uint8* data)
+	{
+		// Slot indices must fit in an entity handle, NullEntity uses the last one.
+		if (header.entityCount > EntityIndex(NullEntity)) return false;
+
+		// Two pools of the same component would be assigned to the same entities twice.
+		std::vector<uint32> names(header.poolCount);
+
+		for (uint32 i = 0; i < header.poolCount; i++)
+		{
+			names[i] = table[i].name;
+		}
+
+		std::sort(names.begin(), names.end());
+
+		if (std::adjacent_find(names.begin(), names.end()) != names.end()) return false;
+
+		constexpr uint32 Free = ~uint32(0);
+
+		// Per slot: Free, or 1 + the last pool that refers to it.
+		std::vector<uint32> marks(header.entityCount, 0);
+
+		for (uint64 i = 0; i < header.entityCount; i++)
+		{
+			if (EntityIndex(slots[i]) != i) return false;
+		}
+
+		for (uint64 i = 0; i < header.freeCount; i++)
+		{
+			const uint32 index = freeSlots[i];
+
+			if (!(index < header.entityCount) || marks[index] == Free) return false;
+
+			marks[index] = Free;
+		}
+
+		for (uint32 i = 0; i < header.poolCount; i++)
+		{
+			const Entity* entities = reinterpret_cast<const Entity*>(data + table[i].entityOffset);
+
+			for (uint64 j = 0; j < table[i].count; j++)
+			{
+				const uint32 index = EntityIndex(entities[j]);
+
+				if (!(index < header.entityCount) || slots[index] != entities[j] || marks[index] == Free || marks[index] == i + 1) return false;
+
+				marks[index] = i + 1;
+			}
+		}
+
+		return true;
+	}
+
+	bool World::SaveFile(const char* filepath, const ComponentRegistry& registry) const
+	{
+		std::vector<WorldFilePool> table;
+		std::vector<const IPool*> sources;
+
+		for (const ComponentRegistry::Entry& entry : registry.GetEntries())
+		{
+			const IPool* pool = entry.id < pools.size() ? pools[entry.id].get() : nullptr;
+
+			if (!pool || pool->Size() == 0) continue;
+
+			table.push_back({ entry.name, entry.size, pool->Size(), 0, 0 });
+			sources.push_back(pool);
+		}
+
+		// Lay out the sections.
+
+		WorldFileHeader header = {};
+		header.magic = WorldFile::Magic;
+		header.version = WorldFile::Version;
+		header.poolCount = static_cast<uint32>(table.size());
+		header.entityCount = entities.size();
+		header.freeCount = freeList.size();
+
+		uint64 offset = sizeof(WorldFileHeader) + sizeof(WorldFilePool) * table.size();
+
+		header.entityOffset = offset = AlignSection(offset);
+		offset += sizeof(Entity) * header.entityCount;
+
+		header.freeOffset = offset = AlignSection(offset);
+		offset += sizeof(uint32) * header.freeCount;
+
+		for (WorldFilePool& pool : table)
+		{
+			pool.entityOffset = offset = AlignSection(offset);
+			offset += sizeof(Entity) * pool.count;
+
+			pool.componentOffset = offset = AlignSection(offset);
+			offset += pool.size * pool.count;
+		}
+
+		// Write them in the same order.
+
+		std::ofstream file(filepath, std::ios::binary);
+
+		if (!file)
+		{
+			FM_LOG(Error) << "Failed to create file " << filepath;
+			return false;
+		}
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(table.data()), sizeof(WorldFilePool) * table.size());
+
+		PadTo(file, header.entityOffset);
+		file.write(reinterpret_cast<const char*>(entities.data()), sizeof(Entity) * entities.size());
+
+		PadTo(file, header.freeOffset);
+		file.write(reinterpret_cast<const char*>(freeList.data()), sizeof(uint32) * freeList.size());
+
+		for (usize i = 0; i < table.size(); i++)
+		{
+			const IPool& pool = *sources[i];
+			const ComponentRegistry::Entry& entry = *registry.Find(table[i].name);
+
+			PadTo(file, table[i].entityOffset);
+			file.write(reinterpret_cast<const char*>(pool.entities.data()), sizeof(Entity) * pool.Size());
+
+			PadTo(file, table[i].componentOffset);
+
+			if (entry.size == 0) continue;
+
+			// Paged pools are written a page at a time.
+			for (usize index = 0; index < pool.Size();)
+			{
+				usize count;
+				const void* components = entry.data(pool, index, count);
+
+				file.write(static_cast<const char*>(components), entry.size * count);
+				index += count;
+			}
+		}
+
+		if (!file)
+		{
+			FM_LOG(Error) << "Failed to write file " << filepath;
+			return false;
+		}
+
+		return true;
+	}
+
+	bool World::LoadFile(const char* filepath, const ComponentRegistry& registry)
+	{
+		FM_ASSERT(entities.empty());
+
+		MappedFile mapping;
+
+		if (!mapping.Open(filepath)) return false;
+
+		const uint8* data = static_cast<const uint8*>(mapping.Data());
+		const usize size = mapping.Size();
+
+		if (size < sizeof(WorldFileHeader))
+		{
+			FM_LOG(Error) << "World file " << filepath << " is truncated";
+			return false;
+		}
+
+		const WorldFileHeader& header = *reinterpret_cast<const WorldFileHeader*>(data);
+
+		if (header.magic != WorldFile::Magic || header.version != WorldFile::Version)
+		{
+			FM_LOG(Error) << "World file " << filepath << " has an unsupported format or version";
+			return false;
+		}
+
+		const WorldFilePool* table = reinterpret_cast<const WorldFilePool*>(data + sizeof(WorldFileHeader));
+
+		bool valid = InFile(sizeof(WorldFileHeader), header.poolCount, sizeof(WorldFilePool), size)
+			&& InFile(header.entityOffset, header.entityCount, sizeof(Entity), size)
+			&& InFile(header.freeOffset, header.freeCount, sizeof(uint32), size);
+
+		for (uint32 i = 0; valid && i < header.poolCount; i++)
+		{
+			valid = InFile(table[i].entityOffset, table[i].count, sizeof(Entity), size)
+				&& InFile(table[i].componentOffset, table[i].count, table[i].size, size);
+		}
+
+		if (!valid)
+		{
+			FM_LOG(Error) << "World file " << filepath << " is truncated";
+			return false;
+		}
+
+		const Entity* slots = reinterpret_cast<const Entity*>(data + header.entityOffset);
+		const uint32* freeSlots = reinterpret_cast<const uint32*>(data + header.freeOffset);
+
+		if (!ValidEntities(header, slots, freeSlots, table, data))
+		{
+			FM_LOG(Error) << "World file " << filepath << " contains invalid entities";
+			return false;
+		}
+
+		entities.assign(slots, slots + header.entityCount);
+		freeList.assign(freeSlots, freeSlots + header.freeCount);
+
+		for (uint32 i = 0; i < header.poolCount; i++)
+		{
+			const WorldFilePool& pool = table[i];
+			const ComponentRegistry::Entry* entry = registry.Find(pool.name);
+
+			if (!entry)
+			{
+				FM_LOG(Warning) << "Skipped pool of unregistered component " << pool.name << " in " << filepath;
+				continue;
+			}
+
+			if (entry->size != pool.size)
+			{
+				FM_LOG(Warning) << "Skipped pool of component " << pool.name << " in " << filepath << ", its size changed";
+				continue;
+			}
+
+			entry->assign(*this, reinterpret_cast<const Entity*>(data + pool.entityOffset), pool.count, data + pool.componentOffset);
+		}
+
+		return true;
+	}
+}
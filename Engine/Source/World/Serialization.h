@@ -0,0 +1,128 @@
+// Copyright (c) 2020 Lauro Oyen, FmEngine contributors. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md for full terms. This notice is not to be removed.
+
+#pragma once
+
+#include "../Utility/CoreTypes.h"
+#include "../Utility/Assert.h"
+#include "../Utility/StringID.h"
+
+#include "Entity.h"
+#include "ComponentType.h"
+#include "Pool.h"
+#include "World.h"
+
+#include <type_traits>
+#include <vector>
+
+namespace FM
+{
+	/// Binary world file, written by World::SaveFile() and read by World::LoadFile().
+	///
+	///     WorldFileHeader
+	///     WorldFilePool[poolCount]
+	///     Sections: the entity slots, the free list, and the entities and components of every pool.
+	///
+	/// Every section starts at a multiple of SectionAlignment, so a mapped file can be read in place.
+	/// Pools refer to their component type by the hash of its registered name, as ComponentIDs differ between runs.
+	/// All values are stored in the native byte order of the machine that wrote the file.
+
+	namespace WorldFile
+	{
+		constexpr uint32 Magic = 0x44574D46;	///< "FMWD".
+		constexpr uint32 Version = 1;			///< Incremented on every change to the layout.
+		constexpr usize SectionAlignment = 64;
+	}
+
+	struct WorldFileHeader
+	{
+		uint32 magic;
+		uint32 version;
+		uint32 poolCount;
+		uint32 reserved;
+		uint64 entityCount;		///< Number of entity slots, including destroyed ones.
+		uint64 entityOffset;
+		uint64 freeCount;
+		uint64 freeOffset;
+	};
+
+	struct WorldFilePool
+	{
+		uint32 name;			///< FNV-1a hash of the registered name of the component type.
+		uint32 size;			///< Size of a component in bytes, 0 for tags which have no component section.
+		uint64 count;
+		uint64 entityOffset;
+		uint64 componentOffset;
+	};
+
+	/// Component types that are written to and read from world files, under a name that is stable between runs.
+	/// Components are stored as raw bytes, so only trivially copyable types can be registered. Pointers and handles
+	/// of other systems in a component have to be fixed up after loading, e.g. by iterating the loaded entities.
+
+	class ComponentRegistry
+	{
+	public:
+
+		struct Entry
+		{
+			uint32 name;
+			ComponentID id;
+			uint32 size;
+
+			/// Returns the components from the dense index on and the number of them that are contiguous.
+			const void* (*data)(const IPool& pool, usize index, usize& count);
+
+			/// Assigns count components of this type to the entities, tags ignore the components.
+			void (*assign)(World& world, const Entity* entities, usize count, const void* components);
+		};
+
+		/// Registers the component type under the given name, which must be unique.
+		template <typename T>
+		void Register(const char* name)
+		{
+			static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable components can be serialized.");
+
+			const uint32 hash = Hash::FNV1a32(name);
+
+			FM_ASSERT(!Find(hash));
+
+			entries.push_back({
+				hash, ComponentType::ID<T>(), std::is_empty_v<T> ? 0 : static_cast<uint32>(sizeof(T)),
+				[](const IPool& pool, usize index, usize& count) -> const void* {
+					const ComponentPool<T>& components = static_cast<const ComponentPool<T>&>(pool);
+					count = components.Contiguous(index);
+					return components.Data(index);
+				},
+				[](World& world, const Entity* entities, usize count, const void* components) {
+					if constexpr (std::is_empty_v<T>)
+					{
+						world.Assign<T>(entities, count);
+					}
+					else
+					{
+						world.Assign<T>(entities, count, static_cast<const T*>(components));
+					}
+				}
+			});
+		}
+
+		/// Returns the entry of the registered name hash, or nullptr if no type was registered under it.
+		const Entry* Find(uint32 name) const
+		{
+			for (const Entry& entry : entries)
+			{
+				if (entry.name == name) return &entry;
+			}
+
+			return nullptr;
+		}
+
+		const std::vector<Entry>& GetEntries() const {
+			return entries;
+		}
+
+	private:
+
+		std::vector<Entry> entries;
+	};
+}
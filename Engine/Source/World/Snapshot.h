@@ -0,0 +1,177 @@
+// Copyright (c) 2020 Lauro Oyen, FmEngine contributors. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md for full terms. This notice is not to be removed.
+
+#pragma once
+
+#include "../Utility/CoreTypes.h"
+#include "../Utility/Assert.h"
+
+#include "Entity.h"
+#include "Pool.h"
+#include "World.h"
+
+#include <memory>
+#include <vector>
+
+namespace FM
+{
+	/// Copy of the state of a world: its pools, groups and entity allocator.
+	/// A pool is only copied when its contents differ from the copy in the snapshot, see IPool::Matches(). Comparing trivially
+	/// copyable components with memcmp only reads memory, so saving and restoring are cheap for pools that didn't change.
+	/// Components that can't be compared are always copied. Pools of components with ComponentTraits::TrackedWrites
+	/// skip the comparison when their revision matches the copy.
+	/// The memory of a snapshot is reused when it is saved again, so a snapshot only allocates while the world grows.
+
+	struct WorldSnapshot
+	{
+		std::vector<std::unique_ptr<IPool>> pools;	///< Copies of the pools, indexed by ComponentID.
+		std::vector<usize> groups;					///< Sizes of the groups, in creation order.
+		std::vector<Entity> entities;
+		std::vector<uint32> freeList;
+		uint32 tick = 0;
+		const World* world = nullptr;				///< World the snapshot was saved from, revisions of other worlds don't compare.
+	};
+
+	inline void World::Save(WorldSnapshot& snapshot)
+	{
+		if (snapshot.world != this)
+		{
+			for (auto& copy : snapshot.pools)
+			{
+				if (copy) copy->revision = 0;
+			}
+
+			snapshot.world = this;
+		}
+
+		snapshot.pools.resize(pools.size());
+
+		for (usize i = 0; i < pools.size(); i++)
+		{
+			IPool* pool = pools[i].get();
+			std::unique_ptr<IPool>& copy = snapshot.pools[i];
+
+			if (!pool) continue;
+
+			if (pool->revision == 0)
+			{
+				pool->revision = ++revision;
+			}
+
+			if (!copy)
+			{
+				copy = pool->Clone();
+			}
+			else if (!pool->Matches(*copy))
+			{
+				copy->CopyFrom(*pool);
+			}
+
+			copy->revision = pool->revision.load();
+		}
+
+		snapshot.groups.resize(groups.size());
+
+		for (usize i = 0; i < groups.size(); i++)
+		{
+			snapshot.groups[i] = groups[i]->size;
+		}
+
+		snapshot.entities = entities;
+		snapshot.freeList = freeList;
+		snapshot.tick = tick;
+	}
+
+	inline void World::Restore(const WorldSnapshot& snapshot)
+	{
+		FM_ASSERT(snapshot.world == this && snapshot.groups.size() <= groups.size());
+
+		for (usize i = 0; i < pools.size(); i++)
+		{
+			IPool* pool = pools[i].get();
+			const IPool* copy = i < snapshot.pools.size() ? snapshot.pools[i].get() : nullptr;
+
+			if (!pool) continue;
+
+			if (!copy)
+			{
+				// The pool was created after the snapshot was saved.
+				pool->Clear();
+			}
+			else
+			{
+				if (!pool->Matches(*copy)) pool->CopyFrom(*copy);
+				pool->revision = copy->revision.load();
+			}
+
+			pool->tick = snapshot.tick;
+		}
+
+		for (usize i = 0; i < groups.size(); i++)
+		{
+			if (i < snapshot.groups.size())
+			{
+				groups[i]->size = snapshot.groups[i];
+			}
+			else
+			{
+				// The group was created after the snapshot was saved, its pools are not packed in the restored order.
+				groups[i]->Refresh();
+			}
+		}
+
+		entities = snapshot.entities;
+		freeList = snapshot.freeList;
+		tick = snapshot.tick;
+	}
+
+	/// Fixed number of snapshots that are reused in a circular fashion, indexed by frame number.
+	/// Keeps the last frames around for rollback, e.g. to resimulate them with corrected input.
+
+	class SnapshotRing
+	{
+	public:
+
+		static constexpr uint64 NoFrame = ~uint64(0);
+
+		SnapshotRing(usize count)
+			: snapshots(count), frames(count, NoFrame)
+		{
+			FM_ASSERT(count > 0);
+		}
+
+		/// Saves the world as the state of the frame, replacing the oldest frame in the ring.
+		void Save(World& world, uint64 frame)
+		{
+			const usize slot = frame % snapshots.size();
+
+			world.Save(snapshots[slot]);
+			frames[slot] = frame;
+		}
+
+		/// Restores the world to the state of the frame.
+		/// Returns false if the frame was never saved or has been replaced by a newer frame.
+		bool Restore(World& world, uint64 frame) const
+		{
+			if (!Has(frame)) return false;
+
+			world.Restore(snapshots[frame % snapshots.size()]);
+			return true;
+		}
+
+		/// Checks if the state of the frame is in the ring.
+		bool Has(uint64 frame) const {
+			return frames[frame % snapshots.size()] == frame;
+		}
+
+		/// Returns the number of frames the ring can hold.
+		usize Size() const {
+			return snapshots.size();
+		}
+
+	private:
+
+		std::vector<WorldSnapshot> snapshots;
+		std::vector<uint64> frames;		///< Frame saved in every snapshot, or NoFrame.
+	};
+}
@@ -0,0 +1,199 @@
+// Copyright (c) 2020 Lauro Oyen, FmEngine contributors. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md for full terms. This notice is not to be removed.
+
+#include "TransformHierarchy.h"
+
+#include "../Utility/Math/Transformations.h"
+#include "../Utility/Threading/JobSystem.h"
+
+#include <algorithm>
+
+namespace FM
+{
+	void TransformHierarchy::Add(Entity entity, const Transform& local, Entity parent)
+	{
+		FM_ASSERT(entity != NullEntity && !Has(entity));
+
+		// A node left behind by a destroyed entity in the same slot would be relinked over the new one.
+		FM_ASSERT(!(EntityIndex(entity) < lookup.size()) || lookup[EntityIndex(entity)] == Null);
+
+		const uint32 p = parent == NullEntity ? Null : Index(parent);
+		const usize pos = p == Null ? entities.size() : p + sizes[p];
+
+		entities.insert(entities.begin() + pos, entity);
+		parents.insert(parents.begin() + pos, p);
+		sizes.insert(sizes.begin() + pos, 1);
+		locals.insert(locals.begin() + pos, local);
+		worlds.insert(worlds.begin() + pos, Matrix4::Identity);
+		dirty.insert(dirty.begin() + pos, 1);
+
+		// Parents precede their children, only nodes after the new one can refer to a shifted parent.
+		for (usize i = pos + 1; i < parents.size(); i++)
+		{
+			if (parents[i] != Null && parents[i] >= pos) parents[i]++;
+		}
+
+		Grow(p, 1);
+
+		if (!(EntityIndex(entity) < lookup.size()))
+		{
+			lookup.resize(EntityIndex(entity) + 1, Null);
+		}
+
+		Relink(pos);
+	}
+
+	void TransformHierarchy::Remove(Entity entity)
+	{
+		const uint32 node = Index(entity);
+		const uint32 count = sizes[node];
+
+		Grow(parents[node], -static_cast<int64>(count));
+
+		for (usize i = node; i < node + count; i++)
+		{
+			lookup[EntityIndex(entities[i])] = Null;
+		}
+
+		entities.erase(entities.begin() + node, entities.begin() + node + count);
+		parents.erase(parents.begin() + node, parents.begin() + node + count);
+		sizes.erase(sizes.begin() + node, sizes.begin() + node + count);
+		locals.erase(locals.begin() + node, locals.begin() + node + count);
+		worlds.erase(worlds.begin() + node, worlds.begin() + node + count);
+		dirty.erase(dirty.begin() + node, dirty.begin() + node + count);
+
+		for (usize i = node; i < parents.size(); i++)
+		{
+			if (parents[i] != Null && parents[i] >= node) parents[i] -= count;
+		}
+
+		Relink(node);
+	}
+
+	void TransformHierarchy::SetParent(Entity entity, Entity parent)
+	{
+		const uint32 node = Index(entity);
+		const uint32 count = sizes[node];
+		const uint32 p = parent == NullEntity ? Null : Index(parent);
+
+		FM_ASSERT(p == Null || !(p >= node && p < node + count));
+
+		// The subtree becomes the last child of the new parent, its position is taken before any sizes change.
+		const usize dest = p == Null ? entities.size() : p + sizes[p];
+
+		Grow(parents[node], -static_cast<int64>(count));
+
+		// Rotate the subtree and the nodes between it and its destination in a single move.
+		// Moving right shifts the nodes in between left by count, moving left shifts them right.
+
+		const usize first = std::min<usize>(node, dest);
+		const usize last = std::max<usize>(node + count, dest);
+		const usize middle = dest > node ? node + count : node;
+		const usize root = dest > node ? dest - count : dest;
+
+		const auto Rotate = [first, middle, last](auto& array) {
+			std::rotate(array.begin() + first, array.begin() + middle, array.begin() + last);
+		};
+
+		Rotate(entities);
+		Rotate(parents);
+		Rotate(sizes);
+		Rotate(locals);
+		Rotate(worlds);
+		Rotate(dirty);
+
+		const auto Moved = [node, count, first, last, root](uint32 index) -> uint32 {
+			if (index == Null || index < first || index >= last) return index;
+			if (index >= node && index < node + count) return static_cast<uint32>(index - node + root);
+			return static_cast<uint32>(index < node ? index + count : index - count);
+		};
+
+		// Parents precede their children, only nodes from the start of the rotated range on can refer to a moved parent.
+		for (usize i = first; i < parents.size(); i++)
+		{
+			parents[i] = Moved(parents[i]);
+		}
+
+		parents[root] = Moved(p);
+		dirty[root] = 1;
+
+		Grow(parents[root], count);
+
+		Relink(first);
+	}
+
+	Entity TransformHierarchy::GetParent(Entity entity) const
+	{
+		const uint32 parent = parents[Index(entity)];
+		return parent == Null ? NullEntity : entities[parent];
+	}
+
+	void TransformHierarchy::SetLocal(Entity entity, const Transform& local)
+	{
+		const uint32 node = Index(entity);
+
+		locals[node] = local;
+		dirty[node] = 1;
+	}
+
+	void TransformHierarchy::Update()
+	{
+		roots.clear();
+
+		for (usize i = 0; i < entities.size(); i += sizes[i])
+		{
+			roots.push_back(static_cast<uint32>(i));
+		}
+
+		GJobSystem.ParallelFor(roots.size(), GJobSystem.BatchSize(roots.size(), 1), [this](usize begin, usize end) {
+			Propagate(roots[begin], end < roots.size() ? roots[end] : entities.size());
+		});
+	}
+
+	void TransformHierarchy::Propagate(usize begin, usize end)
+	{
+		for (usize i = begin; i < end; i++)
+		{
+			const uint32 parent = parents[i];
+
+			if (parent == Null)
+			{
+				if (dirty[i]) worlds[i] = Math::Transformation(locals[i]);
+			}
+			else if (dirty[i] || dirty[parent])
+			{
+				// Mark the node, so its children are updated as well.
+				dirty[i] = 1;
+				worlds[i] = worlds[parent] * Math::Transformation(locals[i]);
+			}
+		}
+
+		std::fill(dirty.begin() + begin, dirty.begin() + end, 0);
+	}
+
+	uint32 TransformHierarchy::Find(Entity entity) const
+	{
+		const uint32 index = EntityIndex(entity);
+
+		if (!(index < lookup.size()) || lookup[index] == Null) return Null;
+
+		return entities[lookup[index]] == entity ? lookup[index] : Null;
+	}
+
+	void TransformHierarchy::Grow(uint32 node, int64 count)
+	{
+		while (node != Null)
+		{
+			sizes[node] = static_cast<uint32>(sizes[node] + count);
+			node = parents[node];
+		}
+	}
+
+	void TransformHierarchy::Relink(usize first)
+	{
+		for (usize i = first; i < entities.size(); i++)
+		{
+			lookup[EntityIndex(entities[i])] = static_cast<uint32>(i);
+		}
+	}
+}
@@ -0,0 +1,107 @@
+// Copyright (c) 2020 Lauro Oyen, FmEngine contributors. All rights reserved.
+// Licensed under the MIT license. See LICENSE.md for full terms. This notice is not to be removed.
+
+#pragma once
+
+#include "../Utility/CoreTypes.h"
+#include "../Utility/Assert.h"
+#include "../Utility/Math/Transform.h"
+#include "../Utility/Math/Matrix.h"
+
+#include "Entity.h"
+
+#include <vector>
+
+namespace FM
+{
+	/// Parent-child relations between entities with a local transform and a cached world matrix.
+	/// Nodes are stored in flat arrays in depth-first order, every subtree occupies a contiguous range
+	/// that starts with its root. Parents always precede their children, so the world matrices are
+	/// updated by a single linear pass, and the subtrees of different roots are updated in parallel.
+	/// Adding, removing or reparenting a node shifts the arrays, these are meant to be rare compared to Update().
+	///
+	/// The hierarchy is independent of World and is not notified when an entity is destroyed:
+	/// callers must Remove() an entity from the hierarchy before they destroy it in the world.
+
+	class TransformHierarchy
+	{
+	public:
+
+		static constexpr uint32 Null = ~uint32(0);	///< Index of a node that is not part of the hierarchy.
+
+		/// Adds an entity as the last child of the parent, or as a new root if the parent is NullEntity.
+		void Add(Entity entity, const Transform& local = Transform(), Entity parent = NullEntity);
+
+		/// Removes an entity and all its descendants, must be called before the entity is destroyed.
+		void Remove(Entity entity);
+
+		/// Moves an entity and its descendants to a new parent, or makes it a root if the parent is NullEntity.
+		/// The local transform is kept, so the world matrix changes with the new parent.
+		/// The subtree is moved as one contiguous range, which costs a single pass over the nodes from the lower end of the move on.
+		void SetParent(Entity entity, Entity parent);
+
+		/// Checks if the entity is part of the hierarchy.
+		bool Has(Entity entity) const {
+			return Find(entity) != Null;
+		}
+
+		/// Returns the parent of the entity, or NullEntity for a root.
+		Entity GetParent(Entity entity) const;
+
+		const Transform& GetLocal(Entity entity) const {
+			return locals[Index(entity)];
+		}
+
+		/// Sets the local transform, the world matrices of the entity and its descendants are updated by the next Update().
+		void SetLocal(Entity entity, const Transform& local);
+
+		/// Returns the world matrix as of the last Update().
+		const Matrix4& GetWorld(Entity entity) const {
+			return worlds[Index(entity)];
+		}
+
+		/// Recomputes the world matrices of all dirty nodes and their descendants.
+		/// Root subtrees are distributed over the job system, clean nodes are skipped.
+		void Update();
+
+		/// Returns the number of nodes.
+		usize Size() const {
+			return entities.size();
+		}
+
+	public:
+
+		// Node data in depth-first order, all arrays are parallel.
+
+		std::vector<Entity> entities;
+		std::vector<uint32> parents;	///< Index of the parent node, or Null for a root.
+		std::vector<uint32> sizes;		///< Number of nodes in the subtree, including the node itself.
+		std::vector<Transform> locals;
+		std::vector<Matrix4> worlds;
+		std::vector<uint8> dirty;		///< Set if the local transform changed since the last Update().
+
+	private:
+
+		/// Returns the index of the node of the entity, or Null if it's not part of the hierarchy.
+		uint32 Find(Entity entity) const;
+
+		uint32 Index(Entity entity) const {
+			FM_ASSERT(Has(entity));
+			return lookup[EntityIndex(entity)];
+		}
+
+		/// Recomputes the dirty nodes in [begin, end), which must contain whole subtrees.
+		void Propagate(usize begin, usize end);
+
+		/// Adds count to the subtree size of the node and all its ancestors.
+		void Grow(uint32 node, int64 count);
+
+		/// Updates the lookup of the nodes from the given index on.
+		void Relink(usize first);
+
+	private:
+
+		std::vector<uint32> lookup;		///< Node index of every entity slot.
+		std::vector<uint32> roots;		///< Scratch list of root nodes used by Update().
+	};
+}
@@ -5,25 +5,43 @@
 
 #include "Pool.h"
 
+#include "../Utility/Threading/JobSystem.h"
+
 #include <array>
 #include <algorithm>
 #include <tuple>
+#include <type_traits>
+#include <utility>
 
 namespace FM
 {
-	template<typename...>
-	class View;
+	/// List of components that entities must not have to be part of a view.
+	template <typename... Component>
+	struct ExcludeType {};
+
+	/// Excludes components from a view, for example GetView<Transform, Rigidbody>(Exclude<Sleeping>).
+	template <typename... Component>
+	inline constexpr ExcludeType<Component...> Exclude{};
+
+	template<typename, typename...>
+	class BasicView;
+
+	/// Iterates all entities that have every one of the given components and none of the excluded ones.
+	/// The smallest pool drives the iteration, membership in the other pools is tested through their sparse index.
+	/// Components are marked as changed when they are handed out by a mutable reference, request them as const to only read them.
 
-	template <typename ...Component>
-	class View
+	template <typename... Excluded, typename... Component>
+	class BasicView<ExcludeType<Excluded...>, Component...>
 	{
 	public:
 
-		template<typename Comp>
-		using component_iterator_type = decltype(std::declval<ComponentPool<Comp>>().begin());
+		/// Pool of a component, const qualified components are read from a const pool.
+		template <typename Comp>
+		using pool_type = std::conditional_t<std::is_const_v<Comp>, const ComponentPool<std::remove_const_t<Comp>>, ComponentPool<Comp>>;
 
 		using underlying_iterator_type = typename std::vector<Entity>::const_iterator;
-		using unchecked_type = std::array<const std::vector<Entity>*, (sizeof...(Component) - 1)>;
+		using unchecked_type = std::array<const IPool*, (sizeof...(Component) - 1)>;
+		using excluded_type = std::array<const IPool*, sizeof...(Excluded)>;
 
 		class Iterator
 		{
@@ -31,17 +49,21 @@ namespace FM
 
 			Iterator() = default;
 
-			Iterator(const std::vector<Entity>* candidate, unchecked_type other, underlying_iterator_type curr)
-				: view(candidate), unchecked(other), it(curr) {}
+			Iterator(const IPool* candidate, unchecked_type other, excluded_type filter, underlying_iterator_type curr)
+				: view(candidate), unchecked(other), excluded(filter), it(curr)
+			{
+				if (it != view->entities.end() && !IsValid()) ++(*this);
+			}
 
 			bool IsValid() const {
-				return std::all_of(unchecked.cbegin(), unchecked.cend(), [entt = *it](const std::vector<Entity>* curr) { return std::find(curr->begin(), curr->end(), entt) != curr->end(); });
+				return std::all_of(unchecked.cbegin(), unchecked.cend(), [entt = *it](const IPool* curr) { return curr->Has(entt); })
+					&& std::none_of(excluded.cbegin(), excluded.cend(), [entt = *it](const IPool* curr) { return curr->Has(entt); });
 			}
 
 		public:
 
 			Iterator& operator++() {
-				while (++it != view->end() && !IsValid());
+				while (++it != view->entities.end() && !IsValid());
 				return *this;
 			}
 
@@ -51,7 +73,7 @@ namespace FM
 			}
 
 			Iterator& operator--() {
-				while (--it != view->begin() && !IsValid());
+				while (--it != view->entities.begin() && !IsValid());
 				return *this;
 			}
 
@@ -78,69 +100,232 @@ namespace FM
 
 		private:
 
-			const std::vector<Entity>* view;
+			const IPool* view;
 			unchecked_type unchecked;
+			excluded_type excluded;
 			underlying_iterator_type it;
 		};
 
-		View(ComponentPool<Component>&... pools)
-			: mPools{ &pools... }
+		BasicView(pool_type<Component>&... pools, const ComponentPool<Excluded>&... excluded)
+			: mPools{ &pools... }, mExcluded{ &excluded... }
 		{}
 
-		const std::vector<Entity>* candidate() const {
-			return std::min({ &std::get<ComponentPool<Component>*>(mPools)->entities... }, [](const auto* lhs, const auto* rhs) {
-				return lhs->size() < rhs->size();
+		/// Returns a copy of the view that iterates in the order of the pool of the given component, instead of the smallest pool.
+		template <typename Comp>
+		BasicView Use() const {
+			BasicView view = *this;
+			view.mDriver = std::get<pool_type<Comp>*>(mPools);
+			return view;
+		}
+
+		/// Returns the pool that drives the iteration, the smallest one unless another one was chosen with Use().
+		const IPool* candidate() const {
+			if (mDriver) return mDriver;
+
+			return std::min({ static_cast<const IPool*>(std::get<pool_type<Component>*>(mPools))... }, [](const IPool* lhs, const IPool* rhs) {
+				return lhs->Size() < rhs->Size();
 			});
 		}
 
-		unchecked_type unchecked(const std::vector<Entity>* view) const {
+		unchecked_type unchecked(const IPool* view) const {
 			usize pos = 0;
 			unchecked_type other{};
-			((&std::get<ComponentPool<Component>*>(mPools)->entities == view ? nullptr : (other[pos++] = &std::get<ComponentPool<Component>*>(mPools)->entities)), ...);
+			((std::get<pool_type<Component>*>(mPools) == view ? nullptr : (other[pos++] = std::get<pool_type<Component>*>(mPools))), ...);
 			return other;
 		}
 
 		/// Estimates the number of entities iterated by the view.
 		usize Size() const {
-			return std::min({ std::get<ComponentPool<Component>*>(mPools)->Size()... });
+			return std::min({ std::get<pool_type<Component>*>(mPools)->Size()... });
 		}
 
 		Iterator begin() const {
-			const auto* view = candidate();
-			return Iterator(view, unchecked(view), view->begin());
+			const IPool* view = candidate();
+			return Iterator(view, unchecked(view), mExcluded, view->entities.begin());
 		}
 
 		Iterator end() const {
-			const auto* view = candidate();
-			return Iterator(view, unchecked(view), view->end());
+			const IPool* view = candidate();
+			return Iterator(view, unchecked(view), mExcluded, view->entities.end());
 		}
 
-		template<typename Comp, typename Other>
-		decltype(auto) get([[maybe_unused]] component_iterator_type<Comp> it, [[maybe_unused]] ComponentPool<Other>* cpool, [[maybe_unused]] const Entity entt) const {
-			if constexpr (std::is_same_v<Comp, Other>) {
-				return *it;
-			}
-			else {
-				return cpool->Get(entt);
+		/// Calls func(Entity entity, Component&... components) for every entity in the view.
+		/// Components are passed by reference, resolving each pool only once per entity.
+		template <typename Func>
+		void Each(Func func) const
+		{
+			const IPool* view = candidate();
+			EachRange(func, view, 0, view->Size());
+		}
+
+		/// Same as Each(), but skips entities whose Tracked component wasn't changed after the given tick.
+		/// Tracked must be one of the components of the view, with or without const.
+		template <typename Tracked, typename Func>
+		void EachChanged(uint32 since, Func func) const
+		{
+			static_assert(Position<Tracked>() < sizeof...(Component), "The tracked component is not part of the view.");
+
+			const IPool* view = candidate();
+			EachRange<Position<Tracked>()>(func, view, 0, view->Size(), since);
+		}
+
+		/// Same as Each(), but splits the entities into batches that are processed in parallel by the job system.
+		/// The callback must be safe to call concurrently for different entities.
+		template <typename Func>
+		void ParallelEach(Func func) const
+		{
+			const IPool* view = candidate();
+
+			GJobSystem.ParallelFor(view->Size(), GJobSystem.BatchSize(view->Size()), [&](usize begin, usize end) {
+				EachRange(func, view, begin, end);
+			});
+		}
+
+		/// Calls func(const Entity* entities, usize count, Component*... components) for every run of entities
+		/// whose components are stored contiguously in all pools. Each array has count elements, tags are passed as nullptr.
+		/// Pools that share an order, like the owned pools of a group, are handed out in a single run.
+		/// Runs are split at the page boundaries of paged pools.
+		template <typename Func>
+		void EachChunk(Func func) const
+		{
+			const IPool* view = candidate();
+			const usize size = view->Size();
+
+			usize i = 0;
+
+			while (i < size)
+			{
+				const index_type first = { Locate<Component>(view, i, view->entities[i])... };
+
+				if (std::find(first.begin(), first.end(), usize(IPool::Null)) != first.end() || IsExcluded(view->entities[i]))
+				{
+					i++;
+					continue;
+				}
+
+				// Largest run that doesn't cross the end of a page in any pool.
+				const usize limit = std::min({ std::get<pool_type<Component>*>(mPools)->Contiguous(first[Position<Component>()])... });
+
+				usize count = 1;
+
+				while (i + count < size && count < limit)
+				{
+					const Entity entity = view->entities[i + count];
+					const index_type index = { Locate<Component>(view, i + count, entity)... };
+
+					if (IsExcluded(entity)) break;
+
+					bool contiguous = true;
+					for (usize p = 0; p < index.size(); p++) contiguous &= index[p] == first[p] + count;
+
+					if (!contiguous) break;
+					count++;
+				}
+
+				(MarkChanged<Component>(first[Position<Component>()], count), ...);
+				InvokeChunk(func, &view->entities[i], count, first, std::index_sequence_for<Component...>{});
+
+				i += count;
 			}
 		}
 
+		/// Returns the requested component(s) of an entity that is part of this view.
+		/// Requesting multiple components returns a tuple of references.
 		template<typename... Comp>
 		decltype(auto) Get(const Entity entt) const {
 			if constexpr (sizeof...(Comp) == 0) {
 				static_assert(sizeof...(Component) == 1);
-				return (std::get<ComponentPool<Component>*>(mPools)->Get(entt), ...);
+				return (std::get<pool_type<Component>*>(mPools)->Get(entt), ...);
 			}
 			else if constexpr (sizeof...(Comp) == 1) {
-				return (std::get<ComponentPool<Comp>*>(mPools)->Get(entt), ...);
+				return (std::get<pool_type<Comp>*>(mPools)->Get(entt), ...);
 			}
 			else {
-				return std::tuple<decltype(get<Comp>({}))... > {get<Comp>(entt)...};
+				return std::forward_as_tuple(std::get<pool_type<Comp>*>(mPools)->Get(entt)...);
 			}
 		}
 
 	private:
 
-		const std::tuple<ComponentPool<Component>*...> mPools;
+		using index_type = std::array<usize, sizeof...(Component)>;
+
+		/// Returns the dense index of the entity in the pool of the component, or IPool::Null if it's missing.
+		template <typename Comp>
+		usize Locate(const IPool* view, usize i, Entity entity) const
+		{
+			const IPool* pool = std::get<pool_type<Comp>*>(mPools);
+			return pool == view ? i : pool->Find(entity);
+		}
+
+		/// Checks if the entity has any of the excluded components.
+		bool IsExcluded(Entity entity) const {
+			return std::any_of(mExcluded.cbegin(), mExcluded.cend(), [entity](const IPool* pool) { return pool->Has(entity); });
+		}
+
+		/// Returns the position of the component in the parameter pack regardless of const, or the size of the pack if it's missing.
+		template <typename Comp>
+		static constexpr usize Position()
+		{
+			usize position = 0;
+			bool found = false;
+			((found = found || std::is_same_v<std::remove_const_t<Comp>, std::remove_const_t<Component>>, position += found ? 0 : 1), ...);
+			return position;
+		}
+
+		/// Stamps count components from the dense index on with the current tick, unless the component is only read.
+		template <typename Comp>
+		void MarkChanged(usize index, usize count) const
+		{
+			if constexpr (!std::is_const_v<Comp>)
+			{
+				ComponentPool<Comp>* pool = std::get<pool_type<Comp>*>(mPools);
+				std::fill_n(pool->ticks.begin() + index, count, pool->tick);
+				pool->Touch();
+			}
+		}
+
+		/// Iterates the entities in [begin, end) of the driving pool.
+		/// If Tracked is the position of a component, entities whose component wasn't changed after since are skipped.
+		template <usize Tracked = sizeof...(Component), typename Func>
+		void EachRange(Func& func, const IPool* view, usize begin, usize end, uint32 since = 0) const
+		{
+			for (usize i = begin; i < end; i++)
+			{
+				const Entity entity = view->entities[i];
+				const index_type index = { Locate<Component>(view, i, entity)... };
+
+				if (std::find(index.begin(), index.end(), usize(IPool::Null)) != index.end() || IsExcluded(entity)) continue;
+
+				if constexpr (Tracked < sizeof...(Component))
+				{
+					if (!std::get<Tracked>(mPools)->ChangedAt(index[Tracked], since)) continue;
+				}
+
+				(MarkChanged<Component>(index[Position<Component>()], 1), ...);
+				Invoke(func, entity, index, std::index_sequence_for<Component...>{});
+			}
+		}
+
+		template <typename Func, std::size_t... I>
+		void Invoke(Func& func, Entity entity, const index_type& index, std::index_sequence<I...>) const
+		{
+			func(entity, *std::get<I>(mPools)->Data(index[I])...);
+		}
+
+		template <typename Func, std::size_t... I>
+		void InvokeChunk(Func& func, const Entity* entities, usize count, const index_type& index, std::index_sequence<I...>) const
+		{
+			func(entities, count, std::get<I>(mPools)->ChunkData(index[I])...);
+		}
+
+	private:
+
+		std::tuple<pool_type<Component>*...> mPools;
+		excluded_type mExcluded;
+		const IPool* mDriver = nullptr;
 	};
+
+	/// View without excluded components.
+	template <typename... Component>
+	using View = BasicView<ExcludeType<>, Component...>;
 }
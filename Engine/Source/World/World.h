@@ -6,72 +6,350 @@
 #include "../Utility/CoreTypes.h"
 #include "../Utility/Assert.h"
 
+#include "Entity.h"
+#include "ComponentType.h"
 #include "Pool.h"
 #include "View.h"
+#include "Group.h"
 
+#include <algorithm>
 #include <vector>
 #include <unordered_map>
 #include <memory>
+#include <type_traits>
+#include <utility>
 
 namespace FM
 {
+	struct WorldSnapshot;
+	class ComponentRegistry;
+
+	/// Owns entities and their components.
+	/// All state is kept per instance, so independent worlds can be used side by side, for example one per thread.
+
 	class World
 	{
 	public:
 
 		/// Creates a new entity.
-		Entity Create() {
-			static uint64 index = 1;
-			return index++;
+		/// Slots of destroyed entities are recycled before new slots are allocated.
+		Entity Create()
+		{
+			if (!freeList.empty())
+			{
+				const uint32 index = freeList.back();
+				freeList.pop_back();
+				return entities[index];
+			}
+
+			const Entity entity = MakeEntity(static_cast<uint32>(entities.size()), 0);
+			entities.push_back(entity);
+			return entity;
+		}
+
+		/// Creates count entities and writes their handles to the array.
+		/// Recycled slots are used first, the remaining entities are appended at once.
+		void Create(Entity* out, usize count)
+		{
+			usize i = 0;
+
+			for (; i < count && !freeList.empty(); i++)
+			{
+				out[i] = entities[freeList.back()];
+				freeList.pop_back();
+			}
+
+			const usize first = entities.size();
+			entities.resize(first + count - i);
+
+			for (usize slot = first; i < count; i++, slot++)
+			{
+				entities[slot] = MakeEntity(static_cast<uint32>(slot), 0);
+				out[i] = entities[slot];
+			}
+		}
+
+		/// Reserves room for the given number of entities and components of each given type.
+		template <typename... Component>
+		void Reserve(usize capacity)
+		{
+			entities.reserve(capacity);
+			(Assure<Component>().Reserve(capacity), ...);
+		}
+
+		/// Creates the pools of the given components if they don't exist yet, const qualifiers are ignored.
+		/// Pools can't be created while other threads access the world, so they are created up front, see Scheduler.
+		template <typename... Component>
+		void Prepare()
+		{
+			(Assure<std::remove_const_t<Component>>(), ...);
+		}
+
+		/// Returns the pool of the component type identifier, or nullptr if no pool has been created for it yet.
+		IPool* FindPool(ComponentID id) {
+			return id < pools.size() ? pools[id].get() : nullptr;
 		}
 
 		/// Destroys an entity and all its components.
-		void Destroy(Entity entity) {
+		/// Handles to the destroyed entity become invalid, even after its slot has been recycled.
+		void Destroy(Entity entity)
+		{
+			FM_ASSERT(Valid(entity));
 
+			for (auto& pool : pools)
+			{
+				if (pool && pool->Has(entity))
+				{
+					OnRemove(*pool, entity);
+					pool->Remove(entity);
+				}
+			}
+
+			const uint32 index = EntityIndex(entity);
+			entities[index] = MakeEntity(index, EntityVersion(entity) + 1);
+			freeList.push_back(index);
+		}
+
+		/// Checks if the entity handle refers to an entity that has not been destroyed.
+		bool Valid(Entity entity) const {
+			const uint32 index = EntityIndex(entity);
+			return index < entities.size() && entities[index] == entity;
+		}
+
+		/// Assigns a component to the given entity, constructed in place from the given arguments.
+		template <typename Component, typename... Args>
+		Component& Assign(Entity entity, Args&&... args)
+		{
+			FM_ASSERT(Valid(entity));
+
+			ComponentPool<Component>& pool = Assure<Component>();
+			pool.Assign(entity, std::forward<Args>(args)...);
+
+			OnAssign(pool, &entity, 1);
+
+			return pool.Get(entity);
 		}
 
-		/// Assigns a component to the given entity.
+		/// Assigns a copy of the prototype to count entities, none of which may have the component yet.
 		template <typename Component>
-		Component& Assign(Entity entity) {
-			return Assure<Component>().Assign(entity);
+		void Assign(const Entity* first, usize count, const Component& prototype = {})
+		{
+			ComponentPool<Component>& pool = Assure<Component>();
+			pool.Assign(first, count, prototype);
+
+			OnAssign(pool, first, count);
+		}
+
+		/// Assigns count components copied from the array to count entities, none of which may have the component yet.
+		template <typename Component>
+		void Assign(const Entity* first, usize count, const Component* components)
+		{
+			ComponentPool<Component>& pool = Assure<Component>();
+			pool.Assign(first, count, components);
+
+			OnAssign(pool, first, count);
 		}
 
 		/// Removes a component from the given entity.
 		template <typename Component>
-		void Remove(Entity entity) {
-			return Assure<Component>().Remove(entity);
+		void Remove(Entity entity)
+		{
+			ComponentPool<Component>& pool = Assure<Component>();
+
+			OnRemove(pool, entity);
+			pool.Remove(entity);
+		}
+
+		/// Modifies a component of the given entity through func(Component& component) and notifies the OnUpdate() listeners.
+		template <typename Component, typename Func>
+		Component& Patch(Entity entity, Func func)
+		{
+			return Assure<Component>().Patch(entity, func);
+		}
+
+		/// Signal that is emitted with the entity after the component was assigned to it.
+		template <typename Component>
+		TSignal<Entity>& OnConstruct() {
+			return Assure<Component>().onConstruct;
+		}
+
+		/// Signal that is emitted with the entity after its component was patched.
+		template <typename Component>
+		TSignal<Entity>& OnUpdate() {
+			return Assure<Component>().onUpdate;
+		}
+
+		/// Signal that is emitted with the entity before the component is removed from it, including when the entity is destroyed.
+		template <typename Component>
+		TSignal<Entity>& OnDestroy() {
+			return Assure<Component>().onDestroy;
 		}
 
 		/// Checks if an entity has all the given components.
 		template <typename... Component>
 		bool Has(Entity entity) const {
-			return (Assure<Component>().Has(entity) && ...);
+			return ((Find<Component>() && Find<Component>()->Has(entity)) && ...);
+		}
+
+		/// Checks if the entity has the component and it was changed after the given tick.
+		template <typename Component>
+		bool Changed(Entity entity, uint32 since) const {
+			const ComponentPool<Component>* pool = Find<Component>();
+			return pool && pool->Changed(entity, since);
 		}
 
-		template<typename... Component>
-		View<Component...> GetView() {
+		/// Returns the current tick, components that are assigned or accessed mutably are stamped with it.
+		uint32 GetTick() const {
+			return tick;
+		}
+
+		/// Advances the tick, typically once per frame.
+		/// Systems remember the tick at which they last ran to find the components changed since.
+		void NextTick()
+		{
+			tick++;
+
+			for (auto& pool : pools)
+			{
+				if (pool) pool->tick = tick;
+			}
+		}
+
+		/// Returns a view of the given components, const qualified components are only read.
+		/// Entities that have any of the excluded components are skipped, e.g. GetView<Transform>(Exclude<Sleeping>).
+		template<typename... Component, typename... Excluded>
+		BasicView<ExcludeType<Excluded...>, Component...> GetView(ExcludeType<Excluded...> = {}) {
 			static_assert(sizeof...(Component) > 0);
-			return { Assure<Component>()... };
+			return { Assure<std::remove_const_t<Component>>()..., Assure<Excluded>()... };
+		}
+
+		/// Sorts the pool of the component, see ComponentPool::Sort().
+		/// The pool must not be owned by a group, as that would break its packed order.
+		template <typename Component, typename Compare>
+		void Sort(Compare compare, ESortAlgorithm algorithm = ESortAlgorithm::Full)
+		{
+			ComponentPool<Component>& pool = Assure<Component>();
+			FM_ASSERT(!Owned(pool));
+			pool.Sort(std::move(compare), algorithm);
+		}
+
+		/// Sorts the pool of the component in the order of the pool of another component, see IPool::SortAs().
+		/// The pool must not be owned by a group.
+		template <typename Component, typename Other>
+		void SortAs()
+		{
+			ComponentPool<Component>& pool = Assure<Component>();
+			FM_ASSERT(!Owned(pool));
+			pool.SortAs(Assure<Other>());
+		}
+
+		/// Returns the owning group of the given components, creating it on first use.
+		/// The group takes ownership of the pools and reorders them so its entities are packed at the front.
+		/// A pool can only be owned by a single group, which must always be requested with the same component order.
+		/// Like pools, groups can't be created while other threads access the world, so systems request them up front.
+		template<typename... Owned>
+		Group<Owned...> GetGroup()
+		{
+			static_assert(sizeof...(Owned) > 0);
+
+			for (auto& group : groups)
+			{
+				if ((group->Owns(&Assure<Owned>()) || ...))
+				{
+					FM_ASSERT((group->Owns(&Assure<Owned>()) && ...));
+					return { static_cast<GroupHandler<Owned...>&>(*group) };
+				}
+			}
+
+			groups.push_back(std::make_unique<GroupHandler<Owned...>>(Assure<Owned>()...));
+
+			return { static_cast<GroupHandler<Owned...>&>(*groups.back()) };
 		}
 
+		/// Copies the entities, components and group state into the snapshot, see Snapshot.h.
+		/// Pools whose contents still match the copy in the snapshot are skipped.
+		void Save(WorldSnapshot& snapshot);
+
+		/// Resets the world to the state of a snapshot that was saved from it, see Snapshot.h.
+		/// Only pools whose contents differ from the snapshot are copied. No signals are emitted.
+		void Restore(const WorldSnapshot& snapshot);
+
+		/// Writes the entities and the components of the registered types to a binary file, see Serialization.h.
+		bool SaveFile(const char* filepath, const ComponentRegistry& registry) const;
+
+		/// Reads a file written by SaveFile() into this world, which must not have any entities yet.
+		/// The file is mapped and every pool is assigned with a single copy from the mapping, groups and signals are updated as usual.
+		/// Pools of component types that are not registered, or whose size changed, are skipped.
+		/// Files with out of range or duplicate entities are rejected before anything is loaded.
+		bool LoadFile(const char* filepath, const ComponentRegistry& registry);
+
 	private:
 
+		/// Returns the pool of the component, creating it on first use.
+		/// Pools are indexed by the component type identifier, which is the same for every world.
 		template <typename Component>
 		ComponentPool<Component>& Assure()
 		{
-			static usize index = pools.size();
+			const ComponentID id = ComponentType::ID<Component>();
+
+			if (!(id < pools.size()))
+			{
+				pools.resize(id + 1);
+			}
 
-			if (!(index < pools.size()))
+			if (!pools[id])
 			{
-				pools.push_back(std::make_unique<ComponentPool<Component>>());
+				pools[id] = std::make_unique<ComponentPool<Component>>();
+				pools[id]->tick = tick;
 			}
 
-			return static_cast<ComponentPool<Component>&>(*pools[index]);
+			return static_cast<ComponentPool<Component>&>(*pools[id]);
+		}
+
+		/// Returns the pool of the component, or nullptr if no pool has been created for it yet.
+		template <typename Component>
+		const ComponentPool<Component>* Find() const
+		{
+			const ComponentID id = ComponentType::ID<Component>();
+			return id < pools.size() ? static_cast<const ComponentPool<Component>*>(pools[id].get()) : nullptr;
+		}
+
+		/// Checks if the pool is owned by a group.
+		bool Owned(const IPool& pool) const
+		{
+			return std::any_of(groups.begin(), groups.end(), [&pool](const std::unique_ptr<IGroup>& group) { return group->Owns(&pool); });
+		}
+
+		/// Keeps the groups owning the pool consistent, must be called after components are assigned.
+		void OnAssign(const IPool& pool, const Entity* first, usize count)
+		{
+			for (auto& group : groups)
+			{
+				if (!group->Owns(&pool)) continue;
+
+				for (usize i = 0; i < count; i++)
+				{
+					group->OnAssign(first[i]);
+				}
+			}
+		}
+
+		/// Keeps the groups owning the pool consistent, must be called before a component is removed.
+		void OnRemove(const IPool& pool, Entity entity)
+		{
+			for (auto& group : groups)
+			{
+				if (group->Owns(&pool)) group->OnRemove(entity);
+			}
 		}
 
 	private:
 
-		std::vector<std::unique_ptr<IPool>> pools;
-		std::vector<Entity> entities;
+		std::vector<std::unique_ptr<IPool>> pools;	///< Indexed by ComponentID, null for components that were never used.
+		std::vector<std::unique_ptr<IGroup>> groups;
+		std::vector<Entity> entities;	///< Current handle of every entity slot.
+		std::vector<uint32> freeList;	///< Indices of destroyed entity slots.
+		uint32 tick = 1;				///< Starts at 1, so every component counts as changed since tick 0.
+		uint64 revision = 0;			///< Last revision handed out to a pool by Save().
 	};
 }